@@ -0,0 +1,543 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TEXPR_H__
+#define __TEXPR_H__
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include "tsimd.h"
+
+// Ленивые выражения над векторами и матрицами
+//
+// Арифметические операторы не считают результат сразу, а возвращают легкий
+// узел выражения. Все выражение вычисляется одним циклом при присваивании
+// вектору/матрице (или при их создании из выражения), без промежуточных
+// временных объектов. Контейнеры хранятся в узлах по ссылке, поэтому узел
+// нельзя сохранять дольше операндов (например, в auto-переменной).
+
+template<typename T> class TDynamicVector;
+template<typename T> class TDynamicMatrix;
+template<typename T> class TMatrixView;
+
+template<typename X>
+TDynamicVector<typename X::value_type> denseMatVec(const X& m, const TDynamicVector<typename X::value_type>& v);
+template<typename X, typename Y>
+TDynamicMatrix<typename X::value_type> denseProduct(const X& a, const Y& b);
+
+template<typename E>
+struct TVectorExpr
+{
+    const E& self() const noexcept { return static_cast<const E&>(*this); }
+};
+
+template<typename E>
+struct TMatrixExpr
+{
+    const E& self() const noexcept { return static_cast<const E&>(*this); }
+};
+
+namespace expr_detail
+{
+    struct OpAdd
+    {
+        template<typename T>
+        static T apply(const T& a, const T& b) { return a + b; }
+    };
+
+    struct OpSub
+    {
+        template<typename T>
+        static T apply(const T& a, const T& b) { return a - b; }
+    };
+
+    struct OpMul
+    {
+        template<typename T>
+        static T apply(const T& a, const T& b) { return a * b; }
+    };
+
+    // контейнеры хранятся по ссылке, узлы и представления - по значению
+    template<typename E>
+    struct Ref { typedef E type; };
+
+    template<typename T>
+    struct Ref<TDynamicVector<T>> { typedef const TDynamicVector<T>& type; };
+
+    template<typename T>
+    struct Ref<TDynamicMatrix<T>> { typedef const TDynamicMatrix<T>& type; };
+}
+
+// поэлементная операция над двумя векторами
+template<typename L, typename R, typename Op>
+class TVectorBinary : public TVectorExpr<TVectorBinary<L, R, Op>>
+{
+    typename expr_detail::Ref<L>::type lhs;
+    typename expr_detail::Ref<R>::type rhs;
+public:
+    typedef typename L::value_type value_type;
+
+    TVectorBinary(const L& l, const R& r) : lhs(l), rhs(r)
+    {
+        if (l.size() != r.size())
+            throw std::invalid_argument("err");
+    }
+
+    size_t size() const noexcept { return lhs.size(); }
+    value_type operator[](size_t i) const { return Op::apply(value_type(lhs[i]), value_type(rhs[i])); }
+
+    const L& left() const noexcept { return lhs; }
+    const R& right() const noexcept { return rhs; }
+};
+
+// операция вектора со скаляром
+template<typename E, typename Op>
+class TVectorScalar : public TVectorExpr<TVectorScalar<E, Op>>
+{
+public:
+    typedef typename E::value_type value_type;
+private:
+    typename expr_detail::Ref<E>::type expr;
+    value_type val;
+public:
+    TVectorScalar(const E& e, const value_type& v) : expr(e), val(v) {}
+
+    size_t size() const noexcept { return expr.size(); }
+    value_type operator[](size_t i) const { return Op::apply(value_type(expr[i]), val); }
+
+    const E& operand() const noexcept { return expr; }
+    const value_type& scalar() const noexcept { return val; }
+};
+
+// поэлементная операция над двумя матрицами
+template<typename L, typename R, typename Op>
+class TMatrixBinary : public TMatrixExpr<TMatrixBinary<L, R, Op>>
+{
+    typename expr_detail::Ref<L>::type lhs;
+    typename expr_detail::Ref<R>::type rhs;
+public:
+    typedef typename L::value_type value_type;
+
+    TMatrixBinary(const L& l, const R& r) : lhs(l), rhs(r)
+    {
+        if (l.rows() != r.rows() || l.cols() != r.cols())
+            throw std::invalid_argument("err");
+    }
+
+    size_t rows() const noexcept { return lhs.rows(); }
+    size_t cols() const noexcept { return lhs.cols(); }
+    value_type operator()(size_t i, size_t j) const { return Op::apply(lhs(i, j), rhs(i, j)); }
+
+    const L& left() const noexcept { return lhs; }
+    const R& right() const noexcept { return rhs; }
+};
+
+// операция матрицы со скаляром
+template<typename E, typename Op>
+class TMatrixScalar : public TMatrixExpr<TMatrixScalar<E, Op>>
+{
+public:
+    typedef typename E::value_type value_type;
+private:
+    typename expr_detail::Ref<E>::type expr;
+    value_type val;
+public:
+    TMatrixScalar(const E& e, const value_type& v) : expr(e), val(v) {}
+
+    size_t rows() const noexcept { return expr.rows(); }
+    size_t cols() const noexcept { return expr.cols(); }
+    value_type operator()(size_t i, size_t j) const { return Op::apply(expr(i, j), val); }
+
+    const E& operand() const noexcept { return expr; }
+    const value_type& scalar() const noexcept { return val; }
+};
+
+// вычисление выражения в непрерывный буфер: общий случай - один
+// слитный цикл, простые узлы над контейнерами - векторные ядра
+template<typename T, typename E>
+void evaluate(T* dst, const TVectorExpr<E>& e)
+{
+    const E& x = e.self();
+    const size_t n = x.size();
+    for (size_t i = 0; i < n; i++)
+        dst[i] = x[i];
+}
+
+template<typename T>
+void evaluate(T* dst, const TVectorExpr<TVectorBinary<TDynamicVector<T>, TDynamicVector<T>, expr_detail::OpAdd>>& e)
+{
+    simdAdd(e.self().left().data(), e.self().right().data(), dst, e.self().size());
+}
+
+template<typename T>
+void evaluate(T* dst, const TVectorExpr<TVectorBinary<TDynamicVector<T>, TDynamicVector<T>, expr_detail::OpSub>>& e)
+{
+    simdSub(e.self().left().data(), e.self().right().data(), dst, e.self().size());
+}
+
+template<typename T>
+void evaluate(T* dst, const TVectorExpr<TVectorScalar<TDynamicVector<T>, expr_detail::OpAdd>>& e)
+{
+    simdAddScalar(e.self().operand().data(), e.self().scalar(), dst, e.self().size());
+}
+
+template<typename T>
+void evaluate(T* dst, const TVectorExpr<TVectorScalar<TDynamicVector<T>, expr_detail::OpSub>>& e)
+{
+    simdSubScalar(e.self().operand().data(), e.self().scalar(), dst, e.self().size());
+}
+
+template<typename T>
+void evaluate(T* dst, const TVectorExpr<TVectorScalar<TDynamicVector<T>, expr_detail::OpMul>>& e)
+{
+    simdMulScalar(e.self().operand().data(), e.self().scalar(), dst, e.self().size());
+}
+
+// матрица вычисляется построчно в буфер с шагом строки ld
+template<typename T, typename E>
+void evaluate(T* dst, size_t ld, const TMatrixExpr<E>& e)
+{
+    const E& x = e.self();
+    const size_t m = x.rows(), n = x.cols();
+    for (size_t i = 0; i < m; i++) {
+        T* r = dst + i * ld;
+        for (size_t j = 0; j < n; j++)
+            r[j] = x(i, j);
+    }
+}
+
+template<typename T>
+void evaluate(T* dst, size_t ld, const TMatrixExpr<TMatrixBinary<TDynamicMatrix<T>, TDynamicMatrix<T>, expr_detail::OpAdd>>& e)
+{
+    const size_t m = e.self().rows(), n = e.self().cols();
+    for (size_t i = 0; i < m; i++)
+        simdAdd(e.self().left()[i].data(), e.self().right()[i].data(), dst + i * ld, n);
+}
+
+template<typename T>
+void evaluate(T* dst, size_t ld, const TMatrixExpr<TMatrixBinary<TDynamicMatrix<T>, TDynamicMatrix<T>, expr_detail::OpSub>>& e)
+{
+    const size_t m = e.self().rows(), n = e.self().cols();
+    for (size_t i = 0; i < m; i++)
+        simdSub(e.self().left()[i].data(), e.self().right()[i].data(), dst + i * ld, n);
+}
+
+template<typename T>
+void evaluate(T* dst, size_t ld, const TMatrixExpr<TMatrixScalar<TDynamicMatrix<T>, expr_detail::OpMul>>& e)
+{
+    const size_t m = e.self().rows(), n = e.self().cols();
+    for (size_t i = 0; i < m; i++)
+        simdMulScalar(e.self().operand()[i].data(), e.self().scalar(), dst + i * ld, n);
+}
+
+// накопление выражения в буфер (составные присваивания): dst += e, dst -= e
+template<typename T, typename E>
+void evaluateAdd(T* dst, const TVectorExpr<E>& e)
+{
+    const E& x = e.self();
+    const size_t n = x.size();
+    for (size_t i = 0; i < n; i++)
+        dst[i] += x[i];
+}
+
+template<typename T>
+void evaluateAdd(T* dst, const TVectorExpr<TDynamicVector<T>>& e)
+{
+    simdAdd(dst, e.self().data(), dst, e.self().size());
+}
+
+template<typename T, typename E>
+void evaluateSub(T* dst, const TVectorExpr<E>& e)
+{
+    const E& x = e.self();
+    const size_t n = x.size();
+    for (size_t i = 0; i < n; i++)
+        dst[i] -= x[i];
+}
+
+template<typename T>
+void evaluateSub(T* dst, const TVectorExpr<TDynamicVector<T>>& e)
+{
+    simdSub(dst, e.self().data(), dst, e.self().size());
+}
+
+template<typename T, typename E>
+void evaluateAdd(T* dst, size_t ld, const TMatrixExpr<E>& e)
+{
+    const E& x = e.self();
+    const size_t m = x.rows(), n = x.cols();
+    for (size_t i = 0; i < m; i++) {
+        T* r = dst + i * ld;
+        for (size_t j = 0; j < n; j++)
+            r[j] += x(i, j);
+    }
+}
+
+template<typename T>
+void evaluateAdd(T* dst, size_t ld, const TMatrixExpr<TDynamicMatrix<T>>& e)
+{
+    const size_t m = e.self().rows(), n = e.self().cols();
+    for (size_t i = 0; i < m; i++)
+        simdAdd(dst + i * ld, e.self()[i].data(), dst + i * ld, n);
+}
+
+template<typename T, typename E>
+void evaluateSub(T* dst, size_t ld, const TMatrixExpr<E>& e)
+{
+    const E& x = e.self();
+    const size_t m = x.rows(), n = x.cols();
+    for (size_t i = 0; i < m; i++) {
+        T* r = dst + i * ld;
+        for (size_t j = 0; j < n; j++)
+            r[j] -= x(i, j);
+    }
+}
+
+template<typename T>
+void evaluateSub(T* dst, size_t ld, const TMatrixExpr<TDynamicMatrix<T>>& e)
+{
+    const size_t m = e.self().rows(), n = e.self().cols();
+    for (size_t i = 0; i < m; i++)
+        simdSub(dst + i * ld, e.self()[i].data(), dst + i * ld, n);
+}
+
+// векторные операции
+template<typename L, typename R>
+TVectorBinary<L, R, expr_detail::OpAdd> operator+(const TVectorExpr<L>& a, const TVectorExpr<R>& b)
+{
+    return TVectorBinary<L, R, expr_detail::OpAdd>(a.self(), b.self());
+}
+
+template<typename L, typename R>
+TVectorBinary<L, R, expr_detail::OpSub> operator-(const TVectorExpr<L>& a, const TVectorExpr<R>& b)
+{
+    return TVectorBinary<L, R, expr_detail::OpSub>(a.self(), b.self());
+}
+
+// скалярное произведение
+template<typename L, typename R>
+typename L::value_type operator*(const TVectorExpr<L>& a, const TVectorExpr<R>& b)
+{
+    const L& x = a.self();
+    const R& y = b.self();
+    if (x.size() != y.size())
+        throw std::invalid_argument("err");
+    typename L::value_type res = typename L::value_type();
+    for (size_t i = 0; i < x.size(); i++)
+        res += x[i] * y[i];
+    return res;
+}
+
+template<typename T>
+T operator*(const TDynamicVector<T>& a, const TDynamicVector<T>& b)
+{
+    if (a.size() != b.size())
+        throw std::invalid_argument("err");
+    return simdDot(a.data(), b.data(), a.size());
+}
+
+// скалярные операции
+template<typename E>
+TVectorScalar<E, expr_detail::OpAdd> operator+(const TVectorExpr<E>& a, const typename E::value_type& val)
+{
+    return TVectorScalar<E, expr_detail::OpAdd>(a.self(), val);
+}
+
+template<typename E>
+TVectorScalar<E, expr_detail::OpSub> operator-(const TVectorExpr<E>& a, const typename E::value_type& val)
+{
+    return TVectorScalar<E, expr_detail::OpSub>(a.self(), val);
+}
+
+template<typename E>
+TVectorScalar<E, expr_detail::OpMul> operator*(const TVectorExpr<E>& a, const typename E::value_type& val)
+{
+    return TVectorScalar<E, expr_detail::OpMul>(a.self(), val);
+}
+
+// матрично-матричные поэлементные операции
+template<typename L, typename R>
+TMatrixBinary<L, R, expr_detail::OpAdd> operator+(const TMatrixExpr<L>& a, const TMatrixExpr<R>& b)
+{
+    return TMatrixBinary<L, R, expr_detail::OpAdd>(a.self(), b.self());
+}
+
+template<typename L, typename R>
+TMatrixBinary<L, R, expr_detail::OpSub> operator-(const TMatrixExpr<L>& a, const TMatrixExpr<R>& b)
+{
+    return TMatrixBinary<L, R, expr_detail::OpSub>(a.self(), b.self());
+}
+
+// матрично-скалярные операции
+template<typename E>
+TMatrixScalar<E, expr_detail::OpMul> operator*(const TMatrixExpr<E>& a, const typename E::value_type& val)
+{
+    return TMatrixScalar<E, expr_detail::OpMul>(a.self(), val);
+}
+
+// Истекающий операнд-контейнер (std::move(a) + b, временный вектор или
+// матрица) отдает свой буфер результату: выражение вычисляется в него на
+// месте, новый буфер не выделяется. Цепочка std::move(a) + b - c * 2
+// обходится без единого выделения памяти.
+template<typename T, typename R>
+TDynamicVector<T> operator+(TDynamicVector<T>&& a, const TVectorExpr<R>& b)
+{
+    a += b;
+    return std::move(a);
+}
+
+template<typename L, typename T>
+TDynamicVector<T> operator+(const TVectorExpr<L>& a, TDynamicVector<T>&& b)
+{
+    b += a;
+    return std::move(b);
+}
+
+template<typename T>
+TDynamicVector<T> operator+(TDynamicVector<T>&& a, TDynamicVector<T>&& b)
+{
+    a += b;
+    return std::move(a);
+}
+
+template<typename T, typename R>
+TDynamicVector<T> operator-(TDynamicVector<T>&& a, const TVectorExpr<R>& b)
+{
+    a -= b;
+    return std::move(a);
+}
+
+template<typename L, typename T>
+TDynamicVector<T> operator-(const TVectorExpr<L>& a, TDynamicVector<T>&& b)
+{
+    b = a - b;
+    return std::move(b);
+}
+
+template<typename T>
+TDynamicVector<T> operator-(TDynamicVector<T>&& a, TDynamicVector<T>&& b)
+{
+    a -= b;
+    return std::move(a);
+}
+
+template<typename T>
+TDynamicVector<T> operator+(TDynamicVector<T>&& a, const typename TDynamicVector<T>::value_type& val)
+{
+    a = a + val;
+    return std::move(a);
+}
+
+template<typename T>
+TDynamicVector<T> operator-(TDynamicVector<T>&& a, const typename TDynamicVector<T>::value_type& val)
+{
+    a = a - val;
+    return std::move(a);
+}
+
+template<typename T>
+TDynamicVector<T> operator*(TDynamicVector<T>&& a, const typename TDynamicVector<T>::value_type& val)
+{
+    a *= val;
+    return std::move(a);
+}
+
+template<typename T, typename R>
+TDynamicMatrix<T> operator+(TDynamicMatrix<T>&& a, const TMatrixExpr<R>& b)
+{
+    a += b;
+    return std::move(a);
+}
+
+template<typename L, typename T>
+TDynamicMatrix<T> operator+(const TMatrixExpr<L>& a, TDynamicMatrix<T>&& b)
+{
+    b += a;
+    return std::move(b);
+}
+
+template<typename T>
+TDynamicMatrix<T> operator+(TDynamicMatrix<T>&& a, TDynamicMatrix<T>&& b)
+{
+    a += b;
+    return std::move(a);
+}
+
+template<typename T, typename R>
+TDynamicMatrix<T> operator-(TDynamicMatrix<T>&& a, const TMatrixExpr<R>& b)
+{
+    a -= b;
+    return std::move(a);
+}
+
+template<typename L, typename T>
+TDynamicMatrix<T> operator-(const TMatrixExpr<L>& a, TDynamicMatrix<T>&& b)
+{
+    b = a - b;
+    return std::move(b);
+}
+
+template<typename T>
+TDynamicMatrix<T> operator-(TDynamicMatrix<T>&& a, TDynamicMatrix<T>&& b)
+{
+    a -= b;
+    return std::move(a);
+}
+
+template<typename T>
+TDynamicMatrix<T> operator*(TDynamicMatrix<T>&& a, const typename TDynamicMatrix<T>::value_type& val)
+{
+    a *= val;
+    return std::move(a);
+}
+
+// произведения не сливаются: выражения-операнды сначала вычисляются,
+// плотные матрицы и представления передаются ядрам без копирования
+template<typename T>
+const TDynamicMatrix<T>& materialize(const TMatrixExpr<TDynamicMatrix<T>>& m)
+{
+    return m.self();
+}
+
+template<typename T>
+TMatrixView<T> materialize(const TMatrixExpr<TMatrixView<T>>& m)
+{
+    return m.self();
+}
+
+template<typename E>
+TDynamicMatrix<typename E::value_type> materialize(const TMatrixExpr<E>& e)
+{
+    return TDynamicMatrix<typename E::value_type>(e);
+}
+
+template<typename T>
+const TDynamicVector<T>& materialize(const TVectorExpr<TDynamicVector<T>>& v)
+{
+    return v.self();
+}
+
+template<typename E>
+TDynamicVector<typename E::value_type> materialize(const TVectorExpr<E>& e)
+{
+    return TDynamicVector<typename E::value_type>(e);
+}
+
+template<typename L, typename R>
+TDynamicMatrix<typename L::value_type> operator*(const TMatrixExpr<L>& a, const TMatrixExpr<R>& b)
+{
+    const auto& x = materialize(a);
+    const auto& y = materialize(b);
+    return denseProduct(x, y);
+}
+
+template<typename L, typename R>
+TDynamicVector<typename L::value_type> operator*(const TMatrixExpr<L>& a, const TVectorExpr<R>& b)
+{
+    const auto& x = materialize(a);
+    const auto& y = materialize(b);
+    return denseMatVec(x, y);
+}
+
+#endif
@@ -0,0 +1,1460 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TIO_H__
+#define __TIO_H__
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "tmatrix.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Двоичный формат матриц, версия 1. Файл - заголовок TBinaryHeader
+// (64 байта), затем разделы данных, каждый с границы BINARY_ALIGNMENT байт:
+//   вектор      - n элементов
+//   плотная     - rows * cols элементов построчно, без выравнивания строк
+//   треугольная - n (n + 1) / 2 элементов, строки упакованы
+//   ленточная   - (kl + ku + 1) * n элементов по диагоналям (AB из LAPACK)
+//   CSR         - начала строк (n + 1 индексов), столбцы и значения (по nnz)
+// Числа записываются в порядке байт записавшей машины, byteOrder позволяет
+// его проверить. Файл можно отобразить в память (TMappedMatrix) и работать
+// с векторами, плотными и CSR матрицами без копирования и разбора.
+
+enum TBinaryFormat : uint32_t
+{
+    BIN_VECTOR = 1,
+    BIN_DENSE = 2,
+    BIN_UPPER_TRIANGULAR = 3,
+    BIN_BAND = 4,
+    BIN_CSR = 5
+};
+
+const uint32_t BINARY_VERSION = 1;
+const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+const size_t BINARY_ALIGNMENT = 64;
+
+struct TBinaryHeader
+{
+    char magic[8];        // "TMATRIX\0"
+    uint32_t version;
+    uint32_t byteOrder;   // BINARY_BYTE_ORDER
+    uint32_t format;      // TBinaryFormat
+    uint32_t dtype;       // см. binaryTypeCode()
+    uint32_t indexSize;   // размер индекса CSR в байтах, иначе 0
+    uint32_t reserved;
+    uint64_t rows, cols;
+    uint64_t param[2];    // ленточная: kl, ku; CSR: nnz, 0
+};
+
+static_assert(sizeof(TBinaryHeader) == 64, "TBinaryHeader should take 64 bytes");
+
+// код типа элемента: вид (1 - знаковое целое, 2 - беззнаковое, 3 - плавающее) << 8 | размер
+template<typename T>
+uint32_t binaryTypeCode()
+{
+    static_assert(std::is_arithmetic<T>::value, "Binary I/O supports arithmetic element types only");
+    uint32_t kind = std::is_floating_point<T>::value ? 3 : std::is_signed<T>::value ? 1 : 2;
+    return kind << 8 | static_cast<uint32_t>(sizeof(T));
+}
+
+inline uint64_t binaryAlign(uint64_t offset)
+{
+    return (offset + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT;
+}
+
+struct TMatrixIO
+{
+    static TBinaryHeader makeHeader(uint32_t format, uint32_t dtype, uint64_t rows, uint64_t cols,
+        uint64_t p0 = 0, uint64_t p1 = 0, uint32_t indexSize = 0)
+    {
+        TBinaryHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "TMATRIX", 8);
+        h.version = BINARY_VERSION;
+        h.byteOrder = BINARY_BYTE_ORDER;
+        h.format = format;
+        h.dtype = dtype;
+        h.indexSize = indexSize;
+        h.rows = rows;
+        h.cols = cols;
+        h.param[0] = p0;
+        h.param[1] = p1;
+        return h;
+    }
+
+    // проверка заголовка, прочитанного из файла
+    static void checkHeader(const TBinaryHeader& h)
+    {
+        if (std::memcmp(h.magic, "TMATRIX", 8) != 0)
+            throw runtime_error("Not a matrix file");
+        if (h.version == 0 || h.version > BINARY_VERSION)
+            throw runtime_error("Unsupported matrix file version");
+        if (h.byteOrder != BINARY_BYTE_ORDER)
+            throw runtime_error("Matrix file has foreign byte order");
+    }
+
+    static void checkHeader(const TBinaryHeader& h, uint32_t format, uint32_t dtype, uint32_t indexSize = 0)
+    {
+        checkHeader(h);
+        if (h.format != format || h.dtype != dtype || h.indexSize != indexSize)
+            throw invalid_argument("Matrix file does not match the requested type");
+    }
+
+    // последовательная запись с выравниванием разделов
+    class Writer
+    {
+        ostream& os;
+        uint64_t pos = 0;
+    public:
+        Writer(ostream& s) : os(s) {}
+
+        void write(const void* p, uint64_t bytes)
+        {
+            os.write(static_cast<const char*>(p), static_cast<streamsize>(bytes));
+            if (!os)
+                throw runtime_error("Matrix write failed");
+            pos += bytes;
+        }
+
+        void align()
+        {
+            static const char zeros[BINARY_ALIGNMENT] = {};
+            write(zeros, binaryAlign(pos) - pos);
+        }
+    };
+
+    class Reader
+    {
+        istream& is;
+        uint64_t pos = 0;
+    public:
+        Reader(istream& s) : is(s) {}
+
+        void read(void* p, uint64_t bytes)
+        {
+            is.read(static_cast<char*>(p), static_cast<streamsize>(bytes));
+            if (!is)
+                throw runtime_error("Matrix read failed: unexpected end of data");
+            pos += bytes;
+        }
+
+        void align()
+        {
+            char pad[BINARY_ALIGNMENT];
+            read(pad, binaryAlign(pos) - pos);
+        }
+    };
+
+    static TBinaryHeader readHeader(Reader& r)
+    {
+        TBinaryHeader h;
+        r.read(&h, sizeof(h));
+        checkHeader(h);
+        return h;
+    }
+
+    template<typename T>
+    static void write(ostream& os, const TDynamicVector<T>& v)
+    {
+        Writer w(os);
+        TBinaryHeader h = makeHeader(BIN_VECTOR, binaryTypeCode<T>(), v.size(), 1);
+        w.write(&h, sizeof(h));
+        w.write(v.data(), v.size() * sizeof(T));
+        w.align();
+    }
+
+    template<typename T>
+    static void read(istream& is, TDynamicVector<T>& v)
+    {
+        Reader r(is);
+        TBinaryHeader h = readHeader(r);
+        checkHeader(h, BIN_VECTOR, binaryTypeCode<T>());
+        TDynamicVector<T> res(static_cast<size_t>(h.rows), TNoInit());
+        r.read(res.data(), res.size() * sizeof(T));
+        r.align();
+        v = std::move(res);
+    }
+
+    template<typename T>
+    static void write(ostream& os, const TDynamicMatrix<T>& m)
+    {
+        Writer w(os);
+        TBinaryHeader h = makeHeader(BIN_DENSE, binaryTypeCode<T>(), m.rows(), m.cols());
+        w.write(&h, sizeof(h));
+        if (m.ld() == m.cols())
+            w.write(m.data(), m.rows() * m.cols() * sizeof(T));
+        else
+            for (size_t i = 0; i < m.rows(); i++)
+                w.write(m.data() + i * m.ld(), m.cols() * sizeof(T));
+        w.align();
+    }
+
+    template<typename T>
+    static void read(istream& is, TDynamicMatrix<T>& m)
+    {
+        Reader r(is);
+        TBinaryHeader h = readHeader(r);
+        checkHeader(h, BIN_DENSE, binaryTypeCode<T>());
+        TDynamicMatrix<T> res(static_cast<size_t>(h.rows), static_cast<size_t>(h.cols), TNoInit());
+        r.read(res.data(), res.rows() * res.cols() * sizeof(T));
+        r.align();
+        m = std::move(res);
+    }
+
+    template<typename T>
+    static void write(ostream& os, const TUpperTriangularMatrix<T>& m)
+    {
+        Writer w(os);
+        TBinaryHeader h = makeHeader(BIN_UPPER_TRIANGULAR, binaryTypeCode<T>(), m.size(), m.size());
+        w.write(&h, sizeof(h));
+        w.write(m.data.data(), m.data.size() * sizeof(T));
+        w.align();
+    }
+
+    template<typename T>
+    static void read(istream& is, TUpperTriangularMatrix<T>& m)
+    {
+        Reader r(is);
+        TBinaryHeader h = readHeader(r);
+        checkHeader(h, BIN_UPPER_TRIANGULAR, binaryTypeCode<T>());
+        TUpperTriangularMatrix<T> res(static_cast<size_t>(h.rows));
+        r.read(res.data.data(), res.data.size() * sizeof(T));
+        r.align();
+        m = std::move(res);
+    }
+
+    template<typename T>
+    static void write(ostream& os, const TBandMatrix<T>& m)
+    {
+        Writer w(os);
+        TBinaryHeader h = makeHeader(BIN_BAND, binaryTypeCode<T>(), m.size(), m.size(),
+            m.lowerBandWidth(), m.upperBandWidth());
+        w.write(&h, sizeof(h));
+        w.write(m.data.data(), m.data.size() * sizeof(T));
+        w.align();
+    }
+
+    template<typename T>
+    static void read(istream& is, TBandMatrix<T>& m)
+    {
+        Reader r(is);
+        TBinaryHeader h = readHeader(r);
+        checkHeader(h, BIN_BAND, binaryTypeCode<T>());
+        TBandMatrix<T> res(static_cast<size_t>(h.rows), static_cast<size_t>(h.param[0]),
+            static_cast<size_t>(h.param[1]));
+        r.read(res.data.data(), res.data.size() * sizeof(T));
+        r.align();
+        m = std::move(res);
+    }
+
+    template<typename T, typename I>
+    static void write(ostream& os, const TCSRMatrix<T, I>& m)
+    {
+        Writer w(os);
+        size_t nnz = m.nonZeros();
+        TBinaryHeader h = makeHeader(BIN_CSR, binaryTypeCode<T>(), m.size(), m.size(), nnz, 0, sizeof(I));
+        w.write(&h, sizeof(h));
+        w.write(m.rows.data(), (m.size() + 1) * sizeof(I));
+        w.align();
+        w.write(m.cols.data(), nnz * sizeof(I));
+        w.align();
+        w.write(m.values.data(), nnz * sizeof(T));
+        w.align();
+    }
+
+    // структура должна быть корректной, иначе умножение выйдет за границы:
+    // rows[0] == 0, rows[n] == nnz, rows не убывает, столбцы меньше n
+    template<typename I>
+    static bool validCSR(uint64_t n, uint64_t nnz, const I* rows, const I* cols)
+    {
+        bool ok = rows[0] == 0 && rows[n] == nnz;
+        for (uint64_t i = 0; ok && i < n; i++)
+            ok = rows[i] <= rows[i + 1];
+        for (uint64_t k = 0; ok && k < nnz; k++)
+            ok = cols[k] < n;
+        return ok;
+    }
+
+    template<typename T, typename I>
+    static void read(istream& is, TCSRMatrix<T, I>& m)
+    {
+        Reader r(is);
+        TBinaryHeader h = readHeader(r);
+        checkHeader(h, BIN_CSR, binaryTypeCode<T>(), sizeof(I));
+        size_t n = static_cast<size_t>(h.rows), nnz = static_cast<size_t>(h.param[0]);
+        TCSRMatrix<T, I> res(n);
+        res.checkedIndex(nnz);
+        res.rows = TDynamicVector<I>(n + 1, TNoInit());
+        res.cols = TDynamicVector<I>(nnz ? nnz : 1, TNoInit());
+        res.values = TDynamicVector<T>(nnz ? nnz : 1, TNoInit());
+        r.read(res.rows.data(), (n + 1) * sizeof(I));
+        r.align();
+        r.read(res.cols.data(), nnz * sizeof(I));
+        r.align();
+        r.read(res.values.data(), nnz * sizeof(T));
+        r.align();
+
+        if (!validCSR(n, nnz, res.rows.data(), res.cols.data()))
+            throw runtime_error("Corrupted CSR matrix file");
+        m = std::move(res);
+    }
+};
+
+template<typename M>
+void writeBinary(ostream& os, const M& m)
+{
+    TMatrixIO::write(os, m);
+}
+
+template<typename M>
+void readBinary(istream& is, M& m)
+{
+    TMatrixIO::read(is, m);
+}
+
+template<typename M>
+void saveBinary(const string& path, const M& m)
+{
+    ofstream os(path, ios::binary);
+    if (!os)
+        throw runtime_error("Cannot open file for writing: " + path);
+    TMatrixIO::write(os, m);
+}
+
+template<typename M>
+void loadBinary(const string& path, M& m)
+{
+    ifstream is(path, ios::binary);
+    if (!is)
+        throw runtime_error("Cannot open file: " + path);
+    TMatrixIO::read(is, m);
+}
+
+// Файл, отображенный в память только для чтения
+class TMappedFile
+{
+    const unsigned char* base = nullptr;
+    size_t len = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    void unmap() noexcept
+    {
+#if defined(_WIN32)
+        if (base)
+            UnmapViewOfFile(base);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (base)
+            munmap(const_cast<unsigned char*>(base), len);
+#endif
+    }
+
+public:
+    explicit TMappedFile(const string& path)
+    {
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+            unmap();
+            throw runtime_error("Cannot open file: " + path);
+        }
+        len = static_cast<size_t>(size.QuadPart);
+        if (len > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+                base = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0)
+                close(fd);
+            throw runtime_error("Cannot open file: " + path);
+        }
+        len = static_cast<size_t>(st.st_size);
+        if (len > 0) {
+            void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+                base = static_cast<const unsigned char*>(p);
+        }
+        close(fd);
+#endif
+        if (!base) {
+            unmap();
+            throw runtime_error("Cannot map file: " + path);
+        }
+    }
+
+    TMappedFile(const TMappedFile&) = delete;
+    TMappedFile& operator=(const TMappedFile&) = delete;
+
+    ~TMappedFile() { unmap(); }
+
+    const unsigned char* data() const noexcept { return base; }
+    size_t size() const noexcept { return len; }
+
+    // count элементов по смещению offset с проверкой границ файла
+    template<typename T>
+    const T* section(uint64_t offset, uint64_t count) const
+    {
+        if (offset > len || count > (len - offset) / sizeof(T))
+            throw runtime_error("Matrix file is truncated");
+        return reinterpret_cast<const T*>(base + offset);
+    }
+};
+
+// Файл матрицы, отображенный в память. Представления, которые он выдает,
+// указывают прямо в отображение и действительны, пока жив объект TMappedMatrix.
+class TMappedMatrix
+{
+    TMappedFile file;
+    TBinaryHeader hdr;
+
+    template<typename T>
+    const T* section(uint64_t offset, uint64_t count) const { return file.section<T>(offset, count); }
+
+public:
+    explicit TMappedMatrix(const string& path) : file(path)
+    {
+        if (file.size() < sizeof(TBinaryHeader))
+            throw runtime_error("Not a matrix file");
+        std::memcpy(&hdr, file.data(), sizeof(hdr));
+        TMatrixIO::checkHeader(hdr);
+    }
+
+    const TBinaryHeader& header() const noexcept { return hdr; }
+
+    template<typename T>
+    TMatrixRow<const T> vector() const
+    {
+        TMatrixIO::checkHeader(hdr, BIN_VECTOR, binaryTypeCode<T>());
+        size_t n = static_cast<size_t>(hdr.rows);
+        return TMatrixRow<const T>(section<T>(sizeof(TBinaryHeader), n), n);
+    }
+
+    template<typename T>
+    TMatrixView<const T> dense() const
+    {
+        TMatrixIO::checkHeader(hdr, BIN_DENSE, binaryTypeCode<T>());
+        size_t r = static_cast<size_t>(hdr.rows), c = static_cast<size_t>(hdr.cols);
+        if (c != 0 && r > std::numeric_limits<uint64_t>::max() / c)
+            throw runtime_error("Corrupted matrix file");
+        return TMatrixView<const T>(section<T>(sizeof(TBinaryHeader), uint64_t(r) * c), r, c, c);
+    }
+
+    // структура CSR проверяется целиком за O(n + nnz), как при чтении из потока
+    template<typename T, typename I = uint32_t>
+    TCSRView<T, I> csr() const
+    {
+        TCSRView<T, I> v = csrUnchecked<T, I>();
+        if (!TMatrixIO::validCSR(v.size(), v.nonZeros(), v.rowStarts(), v.columns()))
+            throw runtime_error("Corrupted CSR matrix file");
+        return v;
+    }
+
+    // без проверки структуры, кроме rows[0] и rows[n] == nnz, - только для
+    // файлов, записанных этой программой
+    template<typename T, typename I = uint32_t>
+    TCSRView<T, I> csrUnchecked() const
+    {
+        TMatrixIO::checkHeader(hdr, BIN_CSR, binaryTypeCode<T>(), sizeof(I));
+        uint64_t n = hdr.rows, nnz = hdr.param[0];
+        if (n >= std::numeric_limits<uint64_t>::max() / sizeof(I) || nnz >= std::numeric_limits<uint64_t>::max() / 16)
+            throw runtime_error("Corrupted matrix file");
+        uint64_t rowsOff = sizeof(TBinaryHeader);
+        uint64_t colsOff = binaryAlign(rowsOff + (n + 1) * sizeof(I));
+        uint64_t valsOff = binaryAlign(colsOff + nnz * sizeof(I));
+        const I* rows = section<I>(rowsOff, n + 1);
+        const I* cols = section<I>(colsOff, nnz);
+        const T* vals = section<T>(valsOff, nnz);
+        if (rows[0] != 0 || rows[n] != nnz)
+            throw runtime_error("Corrupted CSR matrix file");
+        return TCSRView<T, I>(static_cast<size_t>(n), rows, cols, vals);
+    }
+};
+
+// Matrix Market (.mtx), координатный формат: поля real, integer и pattern,
+// симметрии general, symmetric и skew-symmetric. Файл читается блоками по
+// MTX_CHUNK байт, числа разбираются std::from_chars, элементы сразу идут в
+// TCSRBuilder - плотная матрица не строится. Число элементов из заголовка
+// не проверено, поэтому заранее резервируется не больше MTX_RESERVE элементов
+// (вдвое больше для симметричных) и не больше n * n, дальше TCSRBuilder
+// растет сам.
+
+const size_t MTX_CHUNK = size_t(1) << 20;
+const uint64_t MTX_RESERVE = uint64_t(1) << 20;
+
+namespace mtx_detail
+{
+    // построчное чтение потока блоками; строка длиннее блока увеличивает буфер
+    class TLineReader
+    {
+        istream& is;
+        std::vector<char> buf;
+        size_t pos = 0, end = 0, line = 0;
+        bool eof = false;
+
+    public:
+        TLineReader(istream& s) : is(s), buf(MTX_CHUNK) {}
+
+        size_t lineNumber() const noexcept { return line; }
+
+        bool next(const char*& b, const char*& e)
+        {
+            for (;;) {
+                const char* p = buf.data() + pos;
+                const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - pos));
+                if (nl || (eof && pos < end)) {
+                    b = p;
+                    e = nl ? nl : buf.data() + end;
+                    pos = static_cast<size_t>(e - buf.data()) + (nl ? 1 : 0);
+                    if (e > b && e[-1] == '\r')
+                        e--;
+                    line++;
+                    return true;
+                }
+                if (eof)
+                    return false;
+                std::memmove(buf.data(), p, end - pos);
+                end -= pos;
+                pos = 0;
+                if (end == buf.size())
+                    buf.resize(buf.size() * 2);
+                is.read(buf.data() + end, static_cast<streamsize>(buf.size() - end));
+                end += static_cast<size_t>(is.gcount());
+                if (is.bad())
+                    throw runtime_error("Matrix Market read failed");
+                if (!is)
+                    eof = true;
+            }
+        }
+
+        // следующая строка, не пустая и не комментарий
+        bool nextData(const char*& b, const char*& e)
+        {
+            while (next(b, e)) {
+                const char* p = b;
+                while (p < e && std::isspace(static_cast<unsigned char>(*p)))
+                    p++;
+                if (p < e && *p != '%')
+                    return true;
+            }
+            return false;
+        }
+
+        [[noreturn]] void fail(const char* what) const
+        {
+            throw runtime_error("Matrix Market line " + std::to_string(line) + ": " + what);
+        }
+    };
+
+    template<typename V>
+    bool parse(const char*& p, const char* e, V& v)
+    {
+        while (p < e && (*p == ' ' || *p == '\t'))
+            p++;
+        if (p < e && *p == '+')
+            p++;
+        std::from_chars_result r = std::from_chars(p, e, v);
+        if (r.ec != std::errc())
+            return false;
+        p = r.ptr;
+        return true;
+    }
+
+    inline bool onlySpaces(const char* p, const char* e)
+    {
+        while (p < e && std::isspace(static_cast<unsigned char>(*p)))
+            p++;
+        return p == e;
+    }
+
+    inline std::vector<string> lowerTokens(const char* b, const char* e)
+    {
+        std::vector<string> res;
+        string cur;
+        for (const char* p = b; p <= e; p++) {
+            if (p == e || std::isspace(static_cast<unsigned char>(*p))) {
+                if (!cur.empty())
+                    res.push_back(cur);
+                cur.clear();
+            }
+            else
+                cur += static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+        }
+        return res;
+    }
+
+    template<typename V>
+    void append(string& out, V v)
+    {
+        char tmp[64];
+        std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        out.append(tmp, r.ptr);
+    }
+}
+
+template<typename T, typename I>
+void readMatrixMarket(istream& is, TCSRMatrix<T, I>& m)
+{
+    static_assert(std::is_arithmetic<T>::value, "Matrix Market supports arithmetic element types only");
+    mtx_detail::TLineReader r(is);
+    const char *b, *e;
+
+    if (!r.next(b, e))
+        throw runtime_error("Matrix Market file is empty");
+    std::vector<string> banner = mtx_detail::lowerTokens(b, e);
+    if (banner.size() != 5 || banner[0] != "%%matrixmarket" || banner[1] != "matrix")
+        r.fail("bad banner");
+    if (banner[2] != "coordinate")
+        r.fail("only coordinate format is supported");
+    const string& field = banner[3];
+    const string& symmetry = banner[4];
+    bool pattern = field == "pattern", integer = field == "integer";
+    if (!pattern && !integer && field != "real")
+        r.fail("unsupported field type");
+    if (field == "real" && !std::is_floating_point<T>::value)
+        throw invalid_argument("Real Matrix Market data cannot be read into an integer matrix");
+    bool skew = symmetry == "skew-symmetric", sym = skew || symmetry == "symmetric";
+    if (!sym && symmetry != "general")
+        r.fail("unsupported symmetry");
+
+    uint64_t rowsCount, colsCount, count;
+    if (!r.nextData(b, e))
+        r.fail("missing size line");
+    if (!mtx_detail::parse(b, e, rowsCount) || !mtx_detail::parse(b, e, colsCount) ||
+        !mtx_detail::parse(b, e, count) || !mtx_detail::onlySpaces(b, e))
+        r.fail("bad size line");
+    if (rowsCount != colsCount)
+        throw invalid_argument("TCSRMatrix should be square");
+
+    TCSRBuilder<T, I> bld(static_cast<size_t>(rowsCount));
+    uint64_t expected = std::min(count, MTX_RESERVE) * (sym ? 2 : 1);
+    if (rowsCount <= MTX_RESERVE)
+        expected = std::min(expected, rowsCount * rowsCount);
+    bld.reserve(static_cast<size_t>(expected));
+    for (uint64_t k = 0; k < count; k++) {
+        if (!r.nextData(b, e))
+            r.fail("fewer entries than declared");
+        uint64_t i, j;
+        T v = T(1);
+        if (!mtx_detail::parse(b, e, i) || !mtx_detail::parse(b, e, j))
+            r.fail("bad entry");
+        if (i == 0 || j == 0 || i > rowsCount || j > rowsCount)
+            r.fail("entry index out of range");
+        if (integer) {
+            long long x;
+            if (!mtx_detail::parse(b, e, x))
+                r.fail("bad entry value");
+            v = static_cast<T>(x);
+        }
+        else if (!pattern && !mtx_detail::parse(b, e, v))
+            r.fail("bad entry value");
+        if (!mtx_detail::onlySpaces(b, e))
+            r.fail("unexpected text after entry");
+
+        bld.add(static_cast<size_t>(i - 1), static_cast<size_t>(j - 1), v);
+        if (sym && i != j)
+            bld.add(static_cast<size_t>(j - 1), static_cast<size_t>(i - 1), skew ? T() - v : v);
+    }
+    m = bld.build();
+}
+
+// запись в формате coordinate general, индексы с единицы
+template<typename T, typename I>
+void writeMatrixMarket(ostream& os, const TCSRMatrix<T, I>& m)
+{
+    static_assert(std::is_arithmetic<T>::value, "Matrix Market supports arithmetic element types only");
+    TCSRView<T, I> v = m.view();
+    const I* rows = v.rowStarts();
+    const I* cols = v.columns();
+    const T* vals = v.values();
+
+    string out = "%%MatrixMarket matrix coordinate ";
+    out += std::is_floating_point<T>::value ? "real" : "integer";
+    out += " general\n";
+    mtx_detail::append(out, uint64_t(v.size()));
+    out += ' ';
+    mtx_detail::append(out, uint64_t(v.size()));
+    out += ' ';
+    mtx_detail::append(out, uint64_t(v.nonZeros()));
+    out += '\n';
+    out.reserve(MTX_CHUNK + 256);
+
+    for (size_t i = 0; i < v.size(); i++)
+        for (size_t k = rows[i]; k < rows[i + 1]; k++) {
+            mtx_detail::append(out, uint64_t(i + 1));
+            out += ' ';
+            mtx_detail::append(out, uint64_t(cols[k]) + 1);
+            out += ' ';
+            mtx_detail::append(out, vals[k]);
+            out += '\n';
+            if (out.size() >= MTX_CHUNK) {
+                os.write(out.data(), static_cast<streamsize>(out.size()));
+                out.clear();
+            }
+        }
+    os.write(out.data(), static_cast<streamsize>(out.size()));
+    if (!os)
+        throw runtime_error("Matrix Market write failed");
+}
+
+template<typename T, typename I>
+void saveMatrixMarket(const string& path, const TCSRMatrix<T, I>& m)
+{
+    ofstream os(path, ios::binary);
+    if (!os)
+        throw runtime_error("Cannot open file for writing: " + path);
+    writeMatrixMarket(os, m);
+}
+
+template<typename T, typename I>
+void loadMatrixMarket(const string& path, TCSRMatrix<T, I>& m)
+{
+    ifstream is(path, ios::binary);
+    if (!is)
+        throw runtime_error("Cannot open file: " + path);
+    readMatrixMarket(is, m);
+}
+
+// NumPy .npy, версии формата 1.0 - 3.0. Заголовок - словарь Python с полями
+// descr (тип и порядок байт), fortran_order и shape. Векторы - массивы формы
+// (n,), плотные матрицы - (rows, cols) в порядке C или Fortran. Запись идет
+// в порядке C с выравниванием данных на 64 байта, чтобы TMappedNpy выдавал
+// выровненные представления.
+
+namespace npy_detail
+{
+    struct THeader
+    {
+        char byteOrder = '|';       // '<', '>', '|' или '='
+        char kind = 0;              // 'f', 'i', 'u', 'b'
+        size_t itemSize = 0;
+        bool fortranOrder = false;
+        std::vector<size_t> shape;
+        size_t dataOffset = 0;      // начало данных от начала файла
+    };
+
+    inline bool hostLittleEndian() noexcept
+    {
+        const uint16_t one = 1;
+        unsigned char b;
+        std::memcpy(&b, &one, 1);
+        return b == 1;
+    }
+
+    template<typename T>
+    char kindOf()
+    {
+        static_assert(std::is_arithmetic<T>::value, ".npy I/O supports arithmetic element types only");
+        return std::is_same<T, bool>::value ? 'b' : std::is_floating_point<T>::value ? 'f' :
+            std::is_signed<T>::value ? 'i' : 'u';
+    }
+
+    template<typename T>
+    string descrOf()
+    {
+        string d(1, sizeof(T) == 1 ? '|' : hostLittleEndian() ? '<' : '>');
+        d += kindOf<T>();
+        d += std::to_string(sizeof(T));
+        return d;
+    }
+
+    // true - данные записаны в порядке байт этой машины, false - в обратном
+    template<typename T>
+    bool checkType(const THeader& h)
+    {
+        if (h.kind != kindOf<T>() || h.itemSize != sizeof(T))
+            throw invalid_argument(".npy dtype does not match the element type");
+        if (h.byteOrder == '|' || h.byteOrder == '=' || sizeof(T) == 1)
+            return true;
+        return (h.byteOrder == '<') == hostLittleEndian();
+    }
+
+    template<typename T>
+    void swapBytes(T* p, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; i++) {
+            unsigned char* b = reinterpret_cast<unsigned char*>(p + i);
+            std::reverse(b, b + sizeof(T));
+        }
+    }
+
+    // позиция значения ключа key в словаре заголовка
+    inline size_t valueOf(const string& dict, const char* key)
+    {
+        for (char q : { '\'', '"' }) {
+            size_t k = dict.find(q + string(key) + q);
+            if (k != string::npos) {
+                size_t c = dict.find(':', k);
+                if (c == string::npos)
+                    break;
+                return dict.find_first_not_of(" \t", c + 1);
+            }
+        }
+        throw runtime_error(string("Malformed .npy header: no ") + key);
+    }
+
+    // разбор заголовка по первым avail байтам файла; 0 в dataOffset - мало данных
+    inline THeader parseHeader(const unsigned char* p, size_t avail)
+    {
+        THeader h;
+        if (avail < 10 || std::memcmp(p, "\x93NUMPY", 6) != 0)
+            throw runtime_error("Not a .npy file");
+        unsigned major = p[6];
+        size_t pre, len;
+        if (major == 1) {
+            pre = 10;
+            len = size_t(p[8]) | size_t(p[9]) << 8;
+        }
+        else if (major == 2 || major == 3) {
+            if (avail < 12)
+                return h;
+            pre = 12;
+            len = size_t(p[8]) | size_t(p[9]) << 8 | size_t(p[10]) << 16 | size_t(p[11]) << 24;
+        }
+        else
+            throw runtime_error("Unsupported .npy version");
+        if (avail < pre + len)
+            return h;
+
+        string dict(reinterpret_cast<const char*>(p + pre), len);
+        size_t d = valueOf(dict, "descr");
+        if (d == string::npos || (dict[d] != '\'' && dict[d] != '"'))
+            throw runtime_error("Unsupported .npy dtype");
+        size_t e = dict.find(dict[d], d + 1);
+        string descr = e == string::npos ? string() : dict.substr(d + 1, e - d - 1);
+        if (descr.size() < 3 || string("<>|=").find(descr[0]) == string::npos ||
+            string("fiub").find(descr[1]) == string::npos ||
+            descr.find_first_not_of("0123456789", 2) != string::npos)
+            throw runtime_error("Unsupported .npy dtype: " + descr);
+        h.byteOrder = descr[0];
+        h.kind = descr[1];
+        h.itemSize = std::stoul(descr.substr(2));
+
+        size_t f = valueOf(dict, "fortran_order");
+        h.fortranOrder = f != string::npos && dict.compare(f, 4, "True") == 0;
+        if (!h.fortranOrder && (f == string::npos || dict.compare(f, 5, "False") != 0))
+            throw runtime_error("Malformed .npy header: fortran_order");
+
+        size_t sh = valueOf(dict, "shape");
+        size_t close = sh == string::npos ? sh : dict.find(')', sh);
+        if (sh == string::npos || dict[sh] != '(' || close == string::npos)
+            throw runtime_error("Malformed .npy header: shape");
+        const char* q = dict.data() + sh + 1;
+        const char* qe = dict.data() + close;
+        while (q < qe) {
+            while (q < qe && (*q == ' ' || *q == ','))
+                q++;
+            if (q == qe)
+                break;
+            uint64_t x;
+            std::from_chars_result r = std::from_chars(q, qe, x);
+            if (r.ec != std::errc())
+                throw runtime_error("Malformed .npy header: shape");
+            h.shape.push_back(static_cast<size_t>(x));
+            q = r.ptr;
+            if (q < qe && (*q == 'L' || *q == 'l')) // длинные целые Python 2
+                q++;
+        }
+        h.dataOffset = pre + len;
+        return h;
+    }
+
+    inline THeader readHeader(istream& is)
+    {
+        std::vector<unsigned char> buf(12);
+        is.read(reinterpret_cast<char*>(buf.data()), 10);
+        if (!is)
+            throw runtime_error("Not a .npy file");
+        THeader h = parseHeader(buf.data(), 10);
+        if (h.dataOffset == 0 && buf[6] != 1) {
+            is.read(reinterpret_cast<char*>(buf.data() + 10), 2);
+            if (!is)
+                throw runtime_error(".npy read failed: unexpected end of data");
+            h = parseHeader(buf.data(), 12);
+        }
+        if (h.dataOffset == 0) {
+            size_t pre = buf[6] == 1 ? 10 : 12;
+            size_t len = buf[6] == 1 ? size_t(buf[8]) | size_t(buf[9]) << 8 :
+                size_t(buf[8]) | size_t(buf[9]) << 8 | size_t(buf[10]) << 16 | size_t(buf[11]) << 24;
+            buf.resize(pre + len);
+            is.read(reinterpret_cast<char*>(buf.data() + pre), static_cast<streamsize>(len));
+            if (!is)
+                throw runtime_error(".npy read failed: unexpected end of data");
+            h = parseHeader(buf.data(), buf.size());
+        }
+        return h;
+    }
+
+    template<typename T>
+    void writeHeader(ostream& os, const string& shape)
+    {
+        string dict = "{'descr': '" + descrOf<T>() + "', 'fortran_order': False, 'shape': " + shape + ", }";
+        size_t pre = dict.size() + 1 + 10 > 65535 ? 12 : 10;
+        dict.append(binaryAlign(pre + dict.size() + 1) - (pre + dict.size() + 1), ' ');
+        dict += '\n';
+        unsigned char p[12] = { 0x93, 'N', 'U', 'M', 'P', 'Y', static_cast<unsigned char>(pre == 10 ? 1 : 2), 0 };
+        size_t len = dict.size();
+        for (size_t k = 0; k < pre - 8; k++)
+            p[8 + k] = static_cast<unsigned char>(len >> (8 * k));
+        os.write(reinterpret_cast<const char*>(p), static_cast<streamsize>(pre));
+        os.write(dict.data(), static_cast<streamsize>(dict.size()));
+    }
+
+    template<typename T>
+    void readData(istream& is, const THeader& h, T* p, size_t n)
+    {
+        bool native = checkType<T>(h);
+        is.read(reinterpret_cast<char*>(p), static_cast<streamsize>(n * sizeof(T)));
+        if (!is)
+            throw runtime_error(".npy read failed: unexpected end of data");
+        if (!native)
+            swapBytes(p, n);
+    }
+}
+
+template<typename T>
+void writeNpy(ostream& os, const TDynamicVector<T>& v)
+{
+    npy_detail::writeHeader<T>(os, "(" + std::to_string(v.size()) + ",)");
+    os.write(reinterpret_cast<const char*>(v.data()), static_cast<streamsize>(v.size() * sizeof(T)));
+    if (!os)
+        throw runtime_error(".npy write failed");
+}
+
+template<typename T>
+void writeNpy(ostream& os, const TDynamicMatrix<T>& m)
+{
+    npy_detail::writeHeader<T>(os, "(" + std::to_string(m.rows()) + ", " + std::to_string(m.cols()) + ")");
+    if (m.ld() == m.cols())
+        os.write(reinterpret_cast<const char*>(m.data()), static_cast<streamsize>(m.rows() * m.cols() * sizeof(T)));
+    else
+        for (size_t i = 0; i < m.rows(); i++)
+            os.write(reinterpret_cast<const char*>(m.data() + i * m.ld()), static_cast<streamsize>(m.cols() * sizeof(T)));
+    if (!os)
+        throw runtime_error(".npy write failed");
+}
+
+template<typename T>
+void readNpy(istream& is, TDynamicVector<T>& v)
+{
+    npy_detail::THeader h = npy_detail::readHeader(is);
+    if (h.shape.size() != 1)
+        throw invalid_argument(".npy array is not one-dimensional");
+    TDynamicVector<T> res(h.shape[0], TNoInit());
+    npy_detail::readData(is, h, res.data(), res.size());
+    v = std::move(res);
+}
+
+// массив в порядке Fortran транспонируется при загрузке
+template<typename T>
+void readNpy(istream& is, TDynamicMatrix<T>& m)
+{
+    npy_detail::THeader h = npy_detail::readHeader(is);
+    if (h.shape.size() != 2)
+        throw invalid_argument(".npy array is not two-dimensional");
+    size_t r = h.shape[0], c = h.shape[1];
+    if (!h.fortranOrder) {
+        TDynamicMatrix<T> res(r, c, TNoInit());
+        npy_detail::readData(is, h, res.data(), r * c);
+        m = std::move(res);
+        return;
+    }
+    TDynamicMatrix<T> t(c, r, TNoInit()), res(r, c, TNoInit());
+    npy_detail::readData(is, h, t.data(), r * c);
+    for (size_t j = 0; j < c; j++) {
+        const T* col = t.data() + j * r;
+        for (size_t i = 0; i < r; i++)
+            res[i][j] = col[i];
+    }
+    m = std::move(res);
+}
+
+template<typename M>
+void saveNpy(const string& path, const M& m)
+{
+    ofstream os(path, ios::binary);
+    if (!os)
+        throw runtime_error("Cannot open file for writing: " + path);
+    writeNpy(os, m);
+}
+
+template<typename M>
+void loadNpy(const string& path, M& m)
+{
+    ifstream is(path, ios::binary);
+    if (!is)
+        throw runtime_error("Cannot open file: " + path);
+    readNpy(is, m);
+}
+
+// .npy файл, отображенный в память: данные используются без копирования.
+// Для массива в порядке Fortran dense() выдает транспонированную матрицу
+// (cols x rows), так как представления хранят матрицу по строкам.
+class TMappedNpy
+{
+    TMappedFile file;
+    npy_detail::THeader hdr;
+
+    template<typename T>
+    const T* payload(size_t count) const
+    {
+        if (!npy_detail::checkType<T>(hdr))
+            throw invalid_argument(".npy byte order differs from this machine, use loadNpy");
+        return file.section<T>(hdr.dataOffset, count);
+    }
+
+public:
+    explicit TMappedNpy(const string& path) : file(path)
+    {
+        hdr = npy_detail::parseHeader(file.data(), file.size());
+        if (hdr.dataOffset == 0)
+            throw runtime_error(".npy file is truncated");
+    }
+
+    const std::vector<size_t>& shape() const noexcept { return hdr.shape; }
+    bool fortranOrder() const noexcept { return hdr.fortranOrder; }
+
+    template<typename T>
+    TMatrixRow<const T> vector() const
+    {
+        if (hdr.shape.size() != 1)
+            throw invalid_argument(".npy array is not one-dimensional");
+        return TMatrixRow<const T>(payload<T>(hdr.shape[0]), hdr.shape[0]);
+    }
+
+    template<typename T>
+    TMatrixView<const T> dense() const
+    {
+        if (hdr.shape.size() != 2)
+            throw invalid_argument(".npy array is not two-dimensional");
+        size_t r = hdr.shape[0], c = hdr.shape[1];
+        if (hdr.fortranOrder)
+            std::swap(r, c);
+        if (c != 0 && r > std::numeric_limits<size_t>::max() / c)
+            throw runtime_error("Corrupted .npy file");
+        return TMatrixView<const T>(payload<T>(r * c), r, c, c);
+    }
+};
+
+// NumPy .npz (np.savez) - ZIP-архив, каждый член которого - .npy файл с
+// именем массива и расширением .npy. Поддерживаются только несжатые члены
+// (ZIP_STORED): архивы np.savez_compressed и зашифрованные члены отвергаются
+// при чтении. Архивы Zip64, которые numpy создает для больших массивов,
+// читаются; запись ограничена 4 ГБ и 65535 членами. Данные каждого
+// записанного члена начинаются с границы BINARY_ALIGNMENT байт.
+
+namespace npz_detail
+{
+    const uint32_t LOCAL_SIG = 0x04034b50;
+    const uint32_t CENTRAL_SIG = 0x02014b50;
+    const uint32_t END_SIG = 0x06054b50;
+    const uint32_t ZIP64_END_SIG = 0x06064b50;
+    const uint32_t ZIP64_LOCATOR_SIG = 0x07064b50;
+    const uint16_t ZIP64_EXTRA = 0x0001;
+    const uint16_t ALIGN_EXTRA = 0xd935;    // выравнивание данных, как у zipalign
+    const uint16_t DOS_DATE = 0x21;         // 1 января 1980 г.
+    const size_t LOCAL_SIZE = 30, CENTRAL_SIZE = 46, END_SIZE = 22;
+    const size_t ZIP64_END_SIZE = 56, ZIP64_LOCATOR_SIZE = 20;
+    const size_t MAX_COMMENT = 65535;
+
+    struct TEntry
+    {
+        string name;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint32_t crc = 0;
+        uint64_t size = 0;          // сжатый размер; для STORED равен исходному
+        uint64_t offset = 0;        // локальный заголовок от начала файла
+    };
+
+    inline uint64_t getLE(const unsigned char* p, size_t n) noexcept
+    {
+        uint64_t v = 0;
+        for (size_t k = n; k-- > 0; )
+            v = v << 8 | p[k];
+        return v;
+    }
+
+    inline void putLE(string& out, uint64_t v, size_t n)
+    {
+        for (size_t k = 0; k < n; k++, v >>= 8)
+            out += static_cast<char>(v & 0xff);
+    }
+
+    inline uint32_t crc32(uint32_t crc, const char* p, size_t n) noexcept
+    {
+        static const struct TTable
+        {
+            uint32_t t[256];
+            TTable()
+            {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++)
+                        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                    t[i] = c;
+                }
+            }
+        } table;
+        crc = ~crc;
+        for (size_t i = 0; i < n; i++)
+            crc = table.t[(crc ^ static_cast<unsigned char>(p[i])) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    // пропускает запись в другой буфер, считая байты и CRC-32
+    class TCrcBuf : public std::streambuf
+    {
+        std::streambuf* sb;
+        uint32_t sum = 0;
+        uint64_t bytes = 0;
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
+            char ch = traits_type::to_char_type(c);
+            return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            std::streamsize w = sb->sputn(s, n);
+            if (w > 0) {
+                sum = crc32(sum, s, static_cast<size_t>(w));
+                bytes += static_cast<uint64_t>(w);
+            }
+            return w;
+        }
+
+    public:
+        explicit TCrcBuf(std::streambuf* target) : sb(target) {}
+
+        uint32_t crc() const noexcept { return sum; }
+        uint64_t count() const noexcept { return bytes; }
+    };
+
+    inline void readAt(istream& is, uint64_t pos, unsigned char* p, size_t n)
+    {
+        is.seekg(static_cast<streamoff>(pos));
+        is.read(reinterpret_cast<char*>(p), static_cast<streamsize>(n));
+        if (!is)
+            throw runtime_error(".npz read failed: unexpected end of data");
+    }
+
+    // поля, равные 0xffffffff в центральном заголовке, берутся из Zip64 extra
+    inline void applyZip64(const unsigned char* extra, size_t len, uint64_t& usize, uint64_t& csize,
+        uint64_t& offset)
+    {
+        for (size_t k = 0; k + 4 <= len; ) {
+            size_t id = getLE(extra + k, 2), n = getLE(extra + k + 2, 2);
+            if (k + 4 + n > len)
+                break;
+            if (id == ZIP64_EXTRA) {
+                const unsigned char* p = extra + k + 4;
+                const unsigned char* e = p + n;
+                for (uint64_t* f : { &usize, &csize, &offset }) {
+                    if (*f != 0xffffffffu)
+                        continue;
+                    if (e - p < 8)
+                        throw runtime_error("Corrupted .npz file: bad Zip64 field");
+                    *f = getLE(p, 8);
+                    p += 8;
+                }
+                return;
+            }
+            k += 4 + n;
+        }
+    }
+
+    inline std::vector<TEntry> readDirectory(istream& is)
+    {
+        is.seekg(0, ios::end);
+        uint64_t fileSize = static_cast<uint64_t>(is.tellg());
+        if (!is || fileSize < END_SIZE)
+            throw runtime_error("Not a .npz file");
+
+        // конец центрального каталога - последние 22 байта плюс комментарий
+        size_t tail = static_cast<size_t>(std::min<uint64_t>(fileSize, END_SIZE + MAX_COMMENT));
+        std::vector<unsigned char> buf(tail);
+        readAt(is, fileSize - tail, buf.data(), tail);
+        size_t e = tail - END_SIZE + 1;
+        while (e-- > 0 && getLE(buf.data() + e, 4) != END_SIG) {}
+        if (e == size_t(-1))
+            throw runtime_error("Not a .npz file");
+        const unsigned char* end = buf.data() + e;
+        uint64_t endPos = fileSize - tail + e;
+        uint64_t count = getLE(end + 10, 2), dirSize = getLE(end + 12, 4), dirOffset = getLE(end + 16, 4);
+
+        if ((count == 0xffff || dirSize == 0xffffffffu || dirOffset == 0xffffffffu) &&
+            endPos >= ZIP64_LOCATOR_SIZE) {
+            unsigned char loc[ZIP64_LOCATOR_SIZE], rec[ZIP64_END_SIZE];
+            readAt(is, endPos - ZIP64_LOCATOR_SIZE, loc, sizeof(loc));
+            if (getLE(loc, 4) == ZIP64_LOCATOR_SIG) {
+                readAt(is, getLE(loc + 8, 8), rec, sizeof(rec));
+                if (getLE(rec, 4) != ZIP64_END_SIG)
+                    throw runtime_error("Corrupted .npz file: bad Zip64 end record");
+                count = getLE(rec + 32, 8);
+                dirSize = getLE(rec + 40, 8);
+                dirOffset = getLE(rec + 48, 8);
+            }
+        }
+        if (dirOffset > fileSize || dirSize > fileSize - dirOffset || count > dirSize / CENTRAL_SIZE)
+            throw runtime_error("Corrupted .npz file: bad central directory");
+
+        std::vector<unsigned char> dir(static_cast<size_t>(dirSize));
+        if (dirSize)
+            readAt(is, dirOffset, dir.data(), dir.size());
+        std::vector<TEntry> entries(static_cast<size_t>(count));
+        size_t pos = 0;
+        for (TEntry& en : entries) {
+            if (dir.size() - pos < CENTRAL_SIZE || getLE(&dir[pos], 4) != CENTRAL_SIG)
+                throw runtime_error("Corrupted .npz file: bad central directory");
+            const unsigned char* p = &dir[pos];
+            size_t nameLen = getLE(p + 28, 2), extraLen = getLE(p + 30, 2), commentLen = getLE(p + 32, 2);
+            if (dir.size() - pos - CENTRAL_SIZE < nameLen + extraLen + commentLen)
+                throw runtime_error("Corrupted .npz file: bad central directory");
+            en.flags = static_cast<uint16_t>(getLE(p + 8, 2));
+            en.method = static_cast<uint16_t>(getLE(p + 10, 2));
+            en.crc = static_cast<uint32_t>(getLE(p + 16, 4));
+            uint64_t csize = getLE(p + 20, 4), usize = getLE(p + 24, 4);
+            en.offset = getLE(p + 42, 4);
+            en.name.assign(reinterpret_cast<const char*>(p + CENTRAL_SIZE), nameLen);
+            applyZip64(p + CENTRAL_SIZE + nameLen, extraLen, usize, csize, en.offset);
+            en.size = csize;
+            pos += CENTRAL_SIZE + nameLen + extraLen + commentLen;
+        }
+        return entries;
+    }
+
+    inline bool hasNpySuffix(const string& name)
+    {
+        return name.size() >= 4 && name.compare(name.size() - 4, 4, ".npy") == 0;
+    }
+}
+
+// чтение массивов из .npz; имена - как у np.load: без расширения .npy
+class TNpzFile
+{
+    string path;
+    std::vector<npz_detail::TEntry> entries;
+
+    const npz_detail::TEntry& entry(const string& name) const
+    {
+        string full = npz_detail::hasNpySuffix(name) ? name : name + ".npy";
+        for (const npz_detail::TEntry& en : entries)
+            if (en.name == full || en.name == name)
+                return en;
+        throw invalid_argument("No array '" + name + "' in .npz file " + path);
+    }
+
+public:
+    explicit TNpzFile(const string& fileName) : path(fileName)
+    {
+        ifstream is(path, ios::binary);
+        if (!is)
+            throw runtime_error("Cannot open file: " + path);
+        entries = npz_detail::readDirectory(is);
+    }
+
+    std::vector<string> names() const
+    {
+        std::vector<string> res;
+        for (const npz_detail::TEntry& en : entries)
+            res.push_back(npz_detail::hasNpySuffix(en.name) ? en.name.substr(0, en.name.size() - 4) : en.name);
+        return res;
+    }
+
+    bool contains(const string& name) const
+    {
+        string full = npz_detail::hasNpySuffix(name) ? name : name + ".npy";
+        for (const npz_detail::TEntry& en : entries)
+            if (en.name == full || en.name == name)
+                return true;
+        return false;
+    }
+
+    // name - с расширением .npy или без него; M - TDynamicVector или TDynamicMatrix
+    template<typename M>
+    void read(const string& name, M& m) const
+    {
+        using namespace npz_detail;
+        const TEntry& en = entry(name);
+        if (en.flags & 1)
+            throw runtime_error("Encrypted .npz member '" + name + "' is not supported");
+        if (en.method != 0)
+            throw runtime_error("Compressed .npz member '" + name + "' is not supported, use np.savez");
+
+        ifstream is(path, ios::binary);
+        if (!is)
+            throw runtime_error("Cannot open file: " + path);
+        unsigned char local[LOCAL_SIZE];
+        readAt(is, en.offset, local, sizeof(local));
+        if (getLE(local, 4) != LOCAL_SIG)
+            throw runtime_error("Corrupted .npz file: bad local header");
+        uint64_t start = en.offset + LOCAL_SIZE + getLE(local + 26, 2) + getLE(local + 28, 2);
+        is.seekg(static_cast<streamoff>(start));
+
+        M res;
+        readNpy(is, res);
+        if (static_cast<uint64_t>(is.tellg()) - start > en.size)
+            throw runtime_error("Corrupted .npz file: member '" + name + "' is truncated");
+        m = std::move(res);
+    }
+};
+
+// запись массивов в .npz; close() дописывает центральный каталог, деструктор
+// вызывает close() и игнорирует ошибки - вызывайте close() явно
+class TNpzWriter
+{
+    string path;
+    ofstream os;
+    std::vector<npz_detail::TEntry> entries;
+    bool closed = false;
+
+public:
+    explicit TNpzWriter(const string& fileName) : path(fileName), os(fileName, ios::binary)
+    {
+        if (!os)
+            throw runtime_error("Cannot open file for writing: " + path);
+    }
+
+    TNpzWriter(const TNpzWriter&) = delete;
+    TNpzWriter& operator=(const TNpzWriter&) = delete;
+
+    ~TNpzWriter()
+    {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    // M - TDynamicVector или TDynamicMatrix; к имени добавляется .npy
+    template<typename M>
+    void add(const string& name, const M& m)
+    {
+        using namespace npz_detail;
+        if (closed)
+            throw logic_error(".npz archive is already closed");
+        string full = hasNpySuffix(name) ? name : name + ".npy";
+        if (full.size() > 0xffff)
+            throw invalid_argument(".npz member name is too long");
+        for (const TEntry& en : entries)
+            if (en.name == full)
+                throw invalid_argument("Duplicate .npz member '" + name + "'");
+        if (entries.size() == 0xffff)
+            throw runtime_error(".npz archive has too many members");
+
+        TEntry en;
+        en.name = full;
+        en.offset = static_cast<uint64_t>(os.tellp());
+        uint64_t start = en.offset + LOCAL_SIZE + full.size() + 6;
+        size_t pad = static_cast<size_t>(binaryAlign(start) - start);
+        string hdr;
+        putLE(hdr, LOCAL_SIG, 4);
+        putLE(hdr, 20, 2);                  // версия 2.0
+        putLE(hdr, 0, 2);                   // флаги
+        putLE(hdr, 0, 2);                   // STORED
+        putLE(hdr, 0, 2);                   // время
+        putLE(hdr, DOS_DATE, 2);
+        putLE(hdr, 0, 12);                  // CRC и размеры - после записи данных
+        putLE(hdr, full.size(), 2);
+        putLE(hdr, 6 + pad, 2);
+        hdr += full;
+        putLE(hdr, ALIGN_EXTRA, 2);
+        putLE(hdr, 2 + pad, 2);
+        putLE(hdr, BINARY_ALIGNMENT, 2);
+        hdr.append(pad, '\0');
+        os.write(hdr.data(), static_cast<streamsize>(hdr.size()));
+
+        TCrcBuf crcBuf(os.rdbuf());
+        ostream data(&crcBuf);
+        writeNpy(data, m);
+        en.crc = crcBuf.crc();
+        en.size = crcBuf.count();
+        if (en.offset > 0xffffffffu || en.size > 0xffffffffu)
+            throw runtime_error(".npz archives over 4 GB are not supported for writing");
+
+        string sizes;
+        putLE(sizes, en.crc, 4);
+        putLE(sizes, en.size, 4);
+        putLE(sizes, en.size, 4);
+        os.seekp(static_cast<streamoff>(en.offset + 14));
+        os.write(sizes.data(), static_cast<streamsize>(sizes.size()));
+        os.seekp(0, ios::end);
+        if (!os)
+            throw runtime_error(".npz write failed");
+        entries.push_back(en);
+    }
+
+    void close()
+    {
+        using namespace npz_detail;
+        if (closed)
+            return;
+        closed = true;
+        uint64_t dirOffset = static_cast<uint64_t>(os.tellp());
+        string dir;
+        for (const TEntry& en : entries) {
+            putLE(dir, CENTRAL_SIG, 4);
+            putLE(dir, 20, 2);              // создан: MS-DOS, версия 2.0
+            putLE(dir, 20, 2);
+            putLE(dir, 0, 2);
+            putLE(dir, 0, 2);
+            putLE(dir, 0, 2);
+            putLE(dir, DOS_DATE, 2);
+            putLE(dir, en.crc, 4);
+            putLE(dir, en.size, 4);
+            putLE(dir, en.size, 4);
+            putLE(dir, en.name.size(), 2);
+            putLE(dir, 0, 12);              // extra, комментарий, диск, атрибуты
+            putLE(dir, en.offset, 4);
+            dir += en.name;
+        }
+        uint64_t dirSize = dir.size();
+        if (dirOffset + dirSize > 0xffffffffu)
+            throw runtime_error(".npz archives over 4 GB are not supported for writing");
+        putLE(dir, END_SIG, 4);
+        putLE(dir, 0, 4);                   // номера дисков
+        putLE(dir, entries.size(), 2);
+        putLE(dir, entries.size(), 2);
+        putLE(dir, dirSize, 4);
+        putLE(dir, dirOffset, 4);
+        putLE(dir, 0, 2);                   // комментарий
+        os.write(dir.data(), static_cast<streamsize>(dir.size()));
+        os.close();
+        if (!os)
+            throw runtime_error(".npz write failed: " + path);
+    }
+};
+
+#endif
@@ -8,39 +8,124 @@
 #include <stdexcept>
 #include <cassert>
 #include <algorithm>
+#include <type_traits>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <new>
+#include <cstdint>
+#include <limits>
+#include "tthreadpool.h"
+#include "tsimd.h"
+#include "texpr.h"
+#include "ttext.h"
 
 using namespace std;
 
 const int MAX_VECTOR_SIZE = 100000000;
 const int MAX_MATRIX_SIZE = 10000;
+const size_t MEMORY_ALIGNMENT = 64; // выравнивание буферов: строка кэша, вектор AVX-512
+
+namespace alloc_detail
+{
+    // выровненный блок; указатель на исходный блок хранится перед ним
+    inline void* allocateBytes(size_t bytes)
+    {
+        void* raw = ::operator new(bytes + MEMORY_ALIGNMENT + sizeof(void*));
+        uintptr_t p = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+        p = (p + MEMORY_ALIGNMENT - 1) & ~static_cast<uintptr_t>(MEMORY_ALIGNMENT - 1);
+        reinterpret_cast<void**>(p)[-1] = raw;
+        return reinterpret_cast<void*>(p);
+    }
+
+    inline void freeBytes(void* p) noexcept
+    {
+        if (p)
+            ::operator delete(static_cast<void**>(p)[-1]);
+    }
+
+    template<typename T>
+    void destroy(T* p, size_t n) noexcept
+    {
+        if (!std::is_trivially_destructible<T>::value)
+            for (size_t i = 0; i < n; i++)
+                p[i].~T();
+    }
+
+    // n элементов с обнулением (T()) или без него (инициализация по умолчанию)
+    template<typename T>
+    T* allocate(size_t n, bool zero)
+    {
+        T* p = static_cast<T*>(allocateBytes(n * sizeof(T)));
+        size_t i = 0;
+        try {
+            if (zero)
+                for (; i < n; i++)
+                    new (p + i) T();
+            else
+                for (; i < n; i++)
+                    new (p + i) T;
+        }
+        catch (...) {
+            destroy(p, i);
+            freeBytes(p);
+            throw;
+        }
+        return p;
+    }
+
+    template<typename T>
+    void deallocate(T* p, size_t n) noexcept
+    {
+        if (p) {
+            destroy(p, n);
+            freeBytes(p);
+        }
+    }
+}
+
+// двоичный ввод/вывод (tio.h) - доступ к внутреннему хранению матриц
+struct TMatrixIO;
+
+// Тег конструктора без обнуления памяти: элементы только создаются
+// конструктором по умолчанию (для встроенных типов - не инициализируются).
+// Используется для результатов операций, которые сразу перезаписываются.
+struct TNoInit {};
 
 // Динамический вектор - шаблонный вектор на динамической памяти
+// Буфер выровнен на MEMORY_ALIGNMENT байт
 template<typename T>
-class TDynamicVector
+class TDynamicVector : public TVectorExpr<TDynamicVector<T>>
 {
 protected:
     size_t sz;
     T* pMem;
-public:
-    TDynamicVector(size_t size = 1) : sz(size)
+
+    static size_t checkedSize(size_t s)
     {
-        if (sz == 0)
+        if (s == 0)
             throw out_of_range("Vector size should be greater than zero");
-        if (sz > MAX_VECTOR_SIZE)
+        if (s > MAX_VECTOR_SIZE)
             throw out_of_range("err");
-        pMem = new T[sz]();
+        return s;
     }
+public:
+    typedef T value_type;
+
+    TDynamicVector(size_t size = 1) : sz(checkedSize(size)), pMem(alloc_detail::allocate<T>(sz, true)) {}
+
+    TDynamicVector(size_t size, TNoInit) : sz(checkedSize(size)), pMem(alloc_detail::allocate<T>(sz, false)) {}
 
-    TDynamicVector(T* arr, size_t s) : sz(s)
+    TDynamicVector(const T* arr, size_t s) : sz(s)
     {
         assert(arr != nullptr && "TDynamicVector ctor requires non-nullptr arg");
         if (sz > MAX_VECTOR_SIZE)
             throw out_of_range("err");
-        pMem = new T[sz];
+        pMem = alloc_detail::allocate<T>(sz, false);
         std::copy(arr, arr + sz, pMem);
     }
 
-    TDynamicVector(const TDynamicVector& v) : sz(v.sz), pMem(new T[v.sz])
+    TDynamicVector(const TDynamicVector& v) : sz(v.sz), pMem(alloc_detail::allocate<T>(v.sz, false))
     {
         std::copy(v.pMem, v.pMem + sz, pMem);
     }
@@ -51,18 +136,26 @@ public:
         v.pMem = nullptr;
     }
 
+    // вычисление выражения
+    template<typename E>
+    TDynamicVector(const TVectorExpr<E>& e) : TDynamicVector(e.self().size(), TNoInit())
+    {
+        evaluate(pMem, e);
+    }
+
     ~TDynamicVector()
     {
-        delete[] pMem;
+        alloc_detail::deallocate(pMem, sz);
     }
 
     TDynamicVector& operator=(const TDynamicVector& v)
     {
         if (this != &v) {
             if (sz != v.sz) {
-                delete[] pMem;
+                T* p = alloc_detail::allocate<T>(v.sz, false);
+                alloc_detail::deallocate(pMem, sz);
                 sz = v.sz;
-                pMem = new T[sz];
+                pMem = p;
             }
             std::copy(v.pMem, v.pMem + sz, pMem);
         }
@@ -72,7 +165,7 @@ public:
     TDynamicVector& operator=(TDynamicVector&& v) noexcept
     {
         if (this != &v) {
-            delete[] pMem;
+            alloc_detail::deallocate(pMem, sz);
             sz = v.sz;
             pMem = v.pMem;
             v.sz = 0;
@@ -81,7 +174,23 @@ public:
         return *this;
     }
 
+    template<typename E>
+    TDynamicVector& operator=(const TVectorExpr<E>& e)
+    {
+        // выражение может ссылаться на этот вектор: при смене размера
+        // результат сначала строится в новом буфере
+        if (sz != e.self().size()) {
+            TDynamicVector tmp(e);
+            swap(*this, tmp);
+        }
+        else
+            evaluate(pMem, e);
+        return *this;
+    }
+
     size_t size() const noexcept { return sz; }
+    T* data() noexcept { return pMem; }
+    const T* data() const noexcept { return pMem; }
 
     // индексация
     T& operator[](size_t ind)
@@ -124,60 +233,36 @@ public:
         return !(*this == v);
     }
 
-    // скалярные операции
-    TDynamicVector operator+(T val)
-    {
-        TDynamicVector res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res.pMem[i] = pMem[i] + val;
-        return res;
-    }
-
-    TDynamicVector operator-(T val)
-    {
-        TDynamicVector res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res.pMem[i] = pMem[i] - val;
-        return res;
-    }
-
-    TDynamicVector operator*(T val)
+    // составные присваивания - на месте, без выделения памяти
+    template<typename E>
+    TDynamicVector& operator+=(const TVectorExpr<E>& e)
     {
-        TDynamicVector res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res.pMem[i] = pMem[i] * val;
-        return res;
+        if (sz != e.self().size())
+            throw invalid_argument("err");
+        evaluateAdd(pMem, e);
+        return *this;
     }
 
-    // векторные операции
-    TDynamicVector operator+(const TDynamicVector& v)
+    template<typename E>
+    TDynamicVector& operator-=(const TVectorExpr<E>& e)
     {
-        if (sz != v.sz)
+        if (sz != e.self().size())
             throw invalid_argument("err");
-        TDynamicVector res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res.pMem[i] = pMem[i] + v.pMem[i];
-        return res;
+        evaluateSub(pMem, e);
+        return *this;
     }
 
-    TDynamicVector operator-(const TDynamicVector& v)
+    TDynamicVector& operator*=(const T& val)
     {
-        if (sz != v.sz)
-            throw invalid_argument("err");
-        TDynamicVector res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res.pMem[i] = pMem[i] - v.pMem[i];
-        return res;
+        simdMulScalar(pMem, val, pMem, sz);
+        return *this;
     }
 
-    T operator*(const TDynamicVector& v)
+    TDynamicVector& operator/=(const T& val)
     {
-        if (sz != v.sz)
-            throw invalid_argument("err");
-        T res = T();
         for (size_t i = 0; i < sz; i++)
-            res += pMem[i] * v.pMem[i];
-        return res;
+            pMem[i] /= val;
+        return *this;
     }
 
     friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
@@ -189,279 +274,1408 @@ public:
     // ввод/вывод
     friend istream& operator>>(istream& istr, TDynamicVector& v)
     {
-        for (size_t i = 0; i < v.sz; i++)
-            istr >> v.pMem[i];
+        readText(istr, v.pMem, 1, v.sz, v.sz);
         return istr;
     }
 
     friend ostream& operator<<(ostream& ostr, const TDynamicVector& v)
     {
-        for (size_t i = 0; i < v.sz; i++)
-            ostr << v.pMem[i] << ' ';
+        writeText(ostr, v.pMem, 1, v.sz, v.sz, false);
         return ostr;
     }
 };
 
 
-// Динамическая матрица -  шаблонная матрица на динамической памяти
+// Ядро умножения плотных матриц (схема Гото/BLIS)
+//
+// C += A * B, где A - m x k, B - k x n, C - m x n, все матрицы хранятся
+// построчно с шагом строки lda, ldb, ldc. Операнды разбиваются на блоки
+// kc x nc (B, в L3), mc x kc (A, в L2) и упаковываются в непрерывные
+// микропанели, по которым микроядро mr x nr считает блок C в регистрах.
 template<typename T>
-class TDynamicMatrix : public TDynamicVector<TDynamicVector<T>>
+struct TGemmBlocking
 {
-    using TDynamicVector<TDynamicVector<T>>::pMem;
-    using TDynamicVector<TDynamicVector<T>>::sz;
-public:
-    TDynamicMatrix(size_t s = 1) : TDynamicVector<TDynamicVector<T>>(s)
-    {
-        if (s > MAX_MATRIX_SIZE)
-            throw out_of_range("err");
-        for (size_t i = 0; i < sz; i++)
-            pMem[i] = TDynamicVector<T>(sz);
-    }
+    static const size_t mr = 4;
+    static const size_t nr = (sizeof(T) <= 4) ? 16 : 8;
+    static const size_t kc = 256;
+    static const size_t mc = 96;
+    static const size_t nc = 2048;
+};
 
-    // явное объявление доступа к методам базового класса
-    using TDynamicVector<TDynamicVector<T>>::operator[];
-    using TDynamicVector<TDynamicVector<T>>::size;
+template<typename T> const size_t TGemmBlocking<T>::mr;
+template<typename T> const size_t TGemmBlocking<T>::nr;
+template<typename T> const size_t TGemmBlocking<T>::kc;
+template<typename T> const size_t TGemmBlocking<T>::mc;
+template<typename T> const size_t TGemmBlocking<T>::nc;
 
-    // явное объявление метода at() для матрицы
-    TDynamicVector<T>& at(size_t ind)
+namespace gemm_detail
+{
+    // упаковка блока A (mc x kc) в микропанели по mr строк: [панель][p][mr]
+    template<typename T>
+    void packA(size_t mc, size_t kc, const T* A, size_t lda, T* buf)
     {
-        return TDynamicVector<TDynamicVector<T>>::at(ind);
+        const size_t mr = TGemmBlocking<T>::mr;
+        for (size_t i0 = 0; i0 < mc; i0 += mr) {
+            size_t rows = std::min(mr, mc - i0);
+            for (size_t p = 0; p < kc; p++) {
+                for (size_t i = 0; i < rows; i++)
+                    buf[i] = A[(i0 + i) * lda + p];
+                for (size_t i = rows; i < mr; i++)
+                    buf[i] = T();
+                buf += mr;
+            }
+        }
     }
 
-    const TDynamicVector<T>& at(size_t ind) const
+    // упаковка блока B (kc x nc) в микропанели по nr столбцов: [панель][p][nr]
+    template<typename T>
+    void packB(size_t kc, size_t nc, const T* B, size_t ldb, T* buf)
     {
-        return TDynamicVector<TDynamicVector<T>>::at(ind);
+        const size_t nr = TGemmBlocking<T>::nr;
+        for (size_t j0 = 0; j0 < nc; j0 += nr) {
+            size_t cols = std::min(nr, nc - j0);
+            for (size_t p = 0; p < kc; p++) {
+                const T* b = B + p * ldb + j0;
+                for (size_t j = 0; j < cols; j++)
+                    buf[j] = b[j];
+                for (size_t j = cols; j < nr; j++)
+                    buf[j] = T();
+                buf += nr;
+            }
+        }
     }
 
-    // сравнение
-    bool operator==(const TDynamicMatrix& m) const noexcept
+    // микроядро: блок mr x nr накапливается в локальном массиве,
+    // при overwrite записывается в C вместо прибавления
+    template<typename T>
+    void microKernel(size_t kc, const T* a, const T* b, T* C, size_t ldc, size_t rows, size_t cols, bool overwrite)
     {
-        if (sz != m.sz) return false;
-        for (size_t i = 0; i < sz; i++) {
-            if (pMem[i] != m.pMem[i]) return false;
+        const size_t mr = TGemmBlocking<T>::mr;
+        const size_t nr = TGemmBlocking<T>::nr;
+        T acc[mr][nr];
+        for (size_t i = 0; i < mr; i++)
+            for (size_t j = 0; j < nr; j++)
+                acc[i][j] = T();
+
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t i = 0; i < mr; i++) {
+                const T ai = a[i];
+                for (size_t j = 0; j < nr; j++)
+                    acc[i][j] += ai * b[j];
+            }
+            a += mr;
+            b += nr;
+        }
+
+        for (size_t i = 0; i < rows; i++) {
+            T* c = C + i * ldc;
+            if (overwrite)
+                for (size_t j = 0; j < cols; j++)
+                    c[j] = acc[i][j];
+            else
+                for (size_t j = 0; j < cols; j++)
+                    c[j] += acc[i][j];
         }
-        return true;
     }
 
-    bool operator!=(const TDynamicMatrix& m) const noexcept
+    // макроядро: упакованный блок A (mc x kc) на упакованную панель B (kc x nc)
+    template<typename T>
+    void macroKernel(size_t mc, size_t nc, size_t kc, const T* packedA, const T* packedB, T* C, size_t ldc, bool overwrite)
     {
-        return !(*this == m);
+        const size_t mr = TGemmBlocking<T>::mr;
+        const size_t nr = TGemmBlocking<T>::nr;
+        for (size_t j0 = 0; j0 < nc; j0 += nr) {
+            const T* b = packedB + j0 * kc;
+            for (size_t i0 = 0; i0 < mc; i0 += mr) {
+                microKernel(kc, packedA + i0 * kc, b, C + i0 * ldc + j0, ldc,
+                    std::min(mr, mc - i0), std::min(nr, nc - j0), overwrite);
+            }
+        }
     }
 
-    // матрично-скалярные операции
-    TDynamicMatrix operator*(const T& val)
+    // последовательное блочное умножение
+    template<typename T>
+    void gemmSerial(size_t m, size_t n, size_t k, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+        bool overwrite)
     {
-        TDynamicMatrix res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res[i] = pMem[i] * val;
-        return res;
+        typedef TGemmBlocking<T> blk;
+        if (m == 0 || n == 0)
+            return;
+        if (k == 0) {
+            if (overwrite)
+                for (size_t i = 0; i < m; i++)
+                    std::fill(C + i * ldc, C + i * ldc + n, T());
+            return;
+        }
+
+        // на маленьких матрицах упаковка не окупается
+        if (m * n * k <= 64 * 64 * 64) {
+            for (size_t i = 0; i < m; i++) {
+                T* c = C + i * ldc;
+                if (overwrite)
+                    std::fill(c, c + n, T());
+                for (size_t p = 0; p < k; p++) {
+                    const T aip = A[i * lda + p];
+                    const T* b = B + p * ldb;
+                    for (size_t j = 0; j < n; j++)
+                        c[j] += aip * b[j];
+                }
+            }
+            return;
+        }
+
+        const size_t kcMax = std::min(blk::kc, k);
+        const size_t mcMax = std::min(blk::mc, m);
+        const size_t ncMax = std::min(blk::nc, n);
+        TDynamicVector<T> packedA((mcMax + blk::mr) * kcMax, TNoInit());
+        TDynamicVector<T> packedB((ncMax + blk::nr) * kcMax, TNoInit());
+
+        for (size_t jc = 0; jc < n; jc += blk::nc) {
+            size_t nc = std::min(blk::nc, n - jc);
+            for (size_t pc = 0; pc < k; pc += blk::kc) {
+                size_t kc = std::min(blk::kc, k - pc);
+                packB(kc, nc, B + pc * ldb + jc, ldb, packedB.data());
+                for (size_t ic = 0; ic < m; ic += blk::mc) {
+                    size_t mc = std::min(blk::mc, m - ic);
+                    packA(mc, kc, A + ic * lda + pc, lda, packedA.data());
+                    macroKernel(mc, nc, kc, packedA.data(), packedB.data(), C + ic * ldc + jc, ldc,
+                        overwrite && pc == 0);
+                }
+            }
+        }
     }
+}
 
-    // матрично-векторные операции
-    TDynamicVector<T> operator*(const TDynamicVector<T>& v)
+// C += A * B на пуле потоков: C разбивается на независимые плитки,
+// каждая плитка считается последовательным блочным ядром.
+// При overwrite = true вычисляется C = A * B, прежнее содержимое C не читается
+template<typename T>
+void gemm(size_t m, size_t n, size_t k, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+    bool overwrite = false)
+{
+    typedef TGemmBlocking<T> blk;
+    TThreadPool& pool = TThreadPool::instance();
+    size_t threads = pool.threadCount();
+    if (threads == 1 || m * n * k <= 128 * 128 * 128) {
+        gemm_detail::gemmSerial(m, n, k, A, lda, B, ldb, C, ldc, overwrite);
+        return;
+    }
+
+    // по строкам - блоки mc, по столбцам - столько частей, чтобы плиток
+    // было хотя бы вдвое больше потоков (для балансировки)
+    size_t rowTiles = (m + blk::mc - 1) / blk::mc;
+    size_t colTiles = std::max<size_t>(1, (2 * threads + rowTiles - 1) / rowTiles);
+    size_t tileN = (n + colTiles - 1) / colTiles;
+    tileN = (tileN + blk::nr - 1) / blk::nr * blk::nr;
+    colTiles = (n + tileN - 1) / tileN;
+
+    pool.parallelFor(rowTiles * colTiles, [&](size_t t) {
+        size_t i0 = (t / colTiles) * blk::mc;
+        size_t j0 = (t % colTiles) * tileN;
+        size_t mt = std::min(blk::mc, m - i0);
+        size_t nt = std::min(tileN, n - j0);
+        gemm_detail::gemmSerial(mt, nt, k, A + i0 * lda, lda, B + j0, ldb, C + i0 * ldc + j0, ldc, overwrite);
+    });
+}
+
+// Строка матрицы - невладеющее представление непрерывного участка памяти
+template<typename T>
+class TMatrixRow : public TVectorExpr<TMatrixRow<T>>
+{
+    T* pMem;
+    size_t sz;
+public:
+    using value_type = typename std::remove_const<T>::type;
+
+    TMatrixRow(T* p, size_t s) noexcept : pMem(p), sz(s) {}
+    TMatrixRow(const TMatrixRow& r) noexcept = default;
+
+    // присваивание копирует элементы, а не перенаправляет представление
+    TMatrixRow& operator=(const TMatrixRow& r)
     {
-        if (sz != v.size())
+        if (sz != r.sz)
             throw invalid_argument("err");
-        TDynamicVector<T> res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res[i] = pMem[i] * v;
-        return res;
+        std::copy(r.pMem, r.pMem + sz, pMem);
+        return *this;
     }
 
-    // матрично-матричные операции
-    TDynamicMatrix operator+(const TDynamicMatrix& m)
+    template<typename E>
+    TMatrixRow& operator=(const TVectorExpr<E>& e)
     {
-        if (sz != m.sz)
+        if (sz != e.self().size())
             throw invalid_argument("err");
-        TDynamicMatrix res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res[i] = pMem[i] + m[i];
-        return res;
+        evaluate(pMem, e);
+        return *this;
     }
 
-    TDynamicMatrix operator-(const TDynamicMatrix& m)
+    size_t size() const noexcept { return sz; }
+    T* data() const noexcept { return pMem; }
+
+    // индексация
+    T& operator[](size_t ind) const
     {
-        if (sz != m.sz)
-            throw invalid_argument("err");
-        TDynamicMatrix res(sz);
-        for (size_t i = 0; i < sz; i++)
-            res[i] = pMem[i] - m[i];
-        return res;
+        return pMem[ind];
     }
 
-    TDynamicMatrix operator*(const TDynamicMatrix& m)
+    // индексация с контролем
+    T& at(size_t ind) const
     {
-        if (sz != m.sz)
-            throw invalid_argument("err");
-        TDynamicMatrix res(sz);
+        if (ind >= sz)
+            throw out_of_range("err");
+        return pMem[ind];
+    }
+
+    // сравнение
+    bool operator==(const TDynamicVector<value_type>& v) const noexcept
+    {
+        if (sz != v.size()) return false;
         for (size_t i = 0; i < sz; i++) {
-            for (size_t j = 0; j < sz; j++) {
-                T sum = T();
-                for (size_t k = 0; k < sz; k++)
-                    sum += pMem[i][k] * m[k][j];
-                res[i][j] = sum;
-            }
+            if (pMem[i] != v[i]) return false;
         }
-        return res;
+        return true;
+    }
+
+    bool operator!=(const TDynamicVector<value_type>& v) const noexcept
+    {
+        return !(*this == v);
     }
 
     // ввод/вывод
-    friend istream& operator>>(istream& istr, TDynamicMatrix& m)
+    friend istream& operator>>(istream& istr, TMatrixRow r)
     {
-        for (size_t i = 0; i < m.sz; i++)
-            istr >> m.pMem[i];
+        readText(istr, r.pMem, 1, r.sz, r.sz);
         return istr;
     }
 
-    friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& m)
+    friend ostream& operator<<(ostream& ostr, const TMatrixRow& r)
     {
-        for (size_t i = 0; i < m.sz; i++) {
-            for (size_t j = 0; j < m.sz; j++)
-                ostr << m.pMem[i][j] << ' ';
-            ostr << '\n';
-        }
+        writeText(ostr, r.pMem, 1, r.sz, r.sz, false);
         return ostr;
     }
 };
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Верхняя треугольная матрица
+
+
+// Столбец матрицы - невладеющее представление с шагом между элементами
 template<typename T>
-class TUpperTriangularMatrix {
-private:
+class TMatrixColumn : public TVectorExpr<TMatrixColumn<T>>
+{
+    T* pMem;
     size_t sz;
-    TDynamicVector<T> data;
-
+    size_t stride;
 public:
-    TUpperTriangularMatrix(size_t size = 1) : sz(size), data(sz* (sz + 1) / 2) {
-        if (sz == 0) throw out_of_range("err");
-    }
+    typedef typename std::remove_const<T>::type value_type;
 
-    size_t size() const noexcept { return sz; }
+    TMatrixColumn(T* p, size_t s, size_t step) noexcept : pMem(p), sz(s), stride(step) {}
+    TMatrixColumn(const TMatrixColumn& c) noexcept = default;
 
-    // Индексация
-    T& at(size_t i, size_t j) {
-        if (i >= sz || j >= sz || i > j)
-            throw out_of_range("err");
-        return data[i * (2 * sz - i - 1) / 2 + (j - i)];
+    // присваивание копирует элементы, а не перенаправляет представление
+    TMatrixColumn& operator=(const TMatrixColumn& c)
+    {
+        return *this = static_cast<const TVectorExpr<TMatrixColumn>&>(c);
     }
 
-    const T& at(size_t i, size_t j) const {
-        if (i >= sz || j >= sz || i > j)
-            throw out_of_range("err");
-        return data[i * (2 * sz - i - 1) / 2 + (j - i)];
+    template<typename E>
+    TMatrixColumn& operator=(const TVectorExpr<E>& e)
+    {
+        const E& x = e.self();
+        if (sz != x.size())
+            throw invalid_argument("err");
+        for (size_t i = 0; i < sz; i++)
+            pMem[i * stride] = x[i];
+        return *this;
     }
 
-    // безопасное получение элемента
-    T get(size_t i, size_t j) const {
-        return (i <= j && i < sz && j < sz) ? at(i, j) : T();
-    }
+    size_t size() const noexcept { return sz; }
 
-    // умножение на вектор
-    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
-        if (sz != v.size()) throw invalid_argument("err");
+    // индексация
+    T& operator[](size_t ind) const
+    {
+        return pMem[ind * stride];
+    }
 
-        TDynamicVector<T> res(sz);
-        for (size_t i = 0; i < sz; i++) {
-            T sum = T();
-            for (size_t j = i; j < sz; j++) {
-                sum += get(i, j) * v[j];
-            }
-            res[i] = sum;
-        }
-        return res;
+    // индексация с контролем
+    T& at(size_t ind) const
+    {
+        if (ind >= sz)
+            throw out_of_range("err");
+        return pMem[ind * stride];
     }
 };
 
-// Ленточная матрица
-template<typename T>
-class TBandMatrix {
-private:
-    size_t sz;
-    size_t bandWidth;
-    TDynamicVector<T> data; // данные в виде вектора
-    T zero = T();
 
+// Подматрица - невладеющее представление прямоугольного блока плотной
+// матрицы с шагом строки ld. Подходит всем ядрам, принимающим выражения,
+// и умножению (без копирования). Присваивание между перекрывающимися
+// представлениями одной матрицы не поддерживается.
+template<typename T>
+class TMatrixView : public TMatrixExpr<TMatrixView<T>>
+{
+    T* pMem;
+    size_t nRows, nCols, stride;
 public:
-    TBandMatrix(size_t size = 1, size_t bandwidth = 1) : sz(size), bandWidth(bandwidth), data(sz* (2 * bandWidth + 1)) {
-        if (sz == 0)
-            throw out_of_range("err");
-        if (bandWidth >= sz)
-            throw out_of_range("err");
-    }
+    typedef typename std::remove_const<T>::type value_type;
 
-    size_t size() const noexcept { return sz; }
-    size_t getBandWidth() const noexcept { return bandWidth; }
+    TMatrixView(T* p, size_t r, size_t c, size_t ld) noexcept : pMem(p), nRows(r), nCols(c), stride(ld) {}
+    TMatrixView(const TMatrixView& v) noexcept = default;
 
-    // индексация с проверкой на принадлежность ленте
-    T& at(size_t i, size_t j) {
-        if (i >= sz || j >= sz)
-            throw out_of_range("Index out of range");
+    // неконстантное представление приводится к константному
+    template<typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+    TMatrixView(const TMatrixView<U>& v) noexcept : pMem(v.data()), nRows(v.rows()), nCols(v.cols()), stride(v.ld()) {}
 
-        long diff = static_cast<long>(j) - static_cast<long>(i);
-        if (diff > static_cast<long>(bandWidth) || diff < -static_cast<long>(bandWidth))
-            throw out_of_range("Element outside band");
+    // присваивание копирует элементы, а не перенаправляет представление
+    TMatrixView& operator=(const TMatrixView& v)
+    {
+        return *this = static_cast<const TMatrixExpr<TMatrixView>&>(v);
+    }
 
-        return data[i * (2 * bandWidth + 1) + (j - i + bandWidth)];
+    template<typename E>
+    TMatrixView& operator=(const TMatrixExpr<E>& e)
+    {
+        if (nRows != e.self().rows() || nCols != e.self().cols())
+            throw invalid_argument("err");
+        evaluate(pMem, stride, e);
+        return *this;
     }
 
-    const T& at(size_t i, size_t j) const {
-        if (i >= sz || j >= sz)
-            throw out_of_range("Index out of range");
+    template<typename E>
+    TMatrixView& operator+=(const TMatrixExpr<E>& e)
+    {
+        if (nRows != e.self().rows() || nCols != e.self().cols())
+            throw invalid_argument("err");
+        evaluateAdd(pMem, stride, e);
+        return *this;
+    }
 
-        long diff = static_cast<long>(j) - static_cast<long>(i);
-        if (diff > static_cast<long>(bandWidth) || diff < -static_cast<long>(bandWidth))
-            return zero;
+    template<typename E>
+    TMatrixView& operator-=(const TMatrixExpr<E>& e)
+    {
+        if (nRows != e.self().rows() || nCols != e.self().cols())
+            throw invalid_argument("err");
+        evaluateSub(pMem, stride, e);
+        return *this;
+    }
 
-        return data[i * (2 * bandWidth + 1) + (j - i + bandWidth)];
+    TMatrixView& operator*=(const value_type& val)
+    {
+        for (size_t i = 0; i < nRows; i++)
+            simdMulScalar(pMem + i * stride, val, pMem + i * stride, nCols);
+        return *this;
     }
 
-    // умножение на вектор 
-    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
-        if (sz != v.size())
-            throw invalid_argument("err");
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    size_t ld() const noexcept { return stride; }
+    T* data() const noexcept { return pMem; }
 
-        TDynamicVector<T> res(sz);
-        for (size_t i = 0; i < sz; i++) {
-            T sum = T();
-            // границы для оптимизации
-            size_t start_j = (i > bandWidth) ? i - bandWidth : 0;
-            size_t end_j = (i + bandWidth < sz) ? i + bandWidth + 1 : sz;
-
-            for (size_t j = start_j; j < end_j; j++) {
-                long diff = static_cast<long>(j) - static_cast<long>(i);
-                if (diff >= -static_cast<long>(bandWidth) && diff <= static_cast<long>(bandWidth)) {
-                    sum += at(i, j) * v[j];
-                }
-            }
-            res[i] = sum;
-        }
-        return res;
+    T& operator()(size_t i, size_t j) const noexcept { return pMem[i * stride + j]; }
+
+    // индексация
+    TMatrixRow<T> operator[](size_t ind) const
+    {
+        return TMatrixRow<T>(pMem + ind * stride, nCols);
     }
-};
 
-// CSR матрица
+    // индексация с контролем
+    TMatrixRow<T> at(size_t ind) const
+    {
+        if (ind >= nRows)
+            throw out_of_range("err");
+        return (*this)[ind];
+    }
 
-template<typename T>
-class TCSRMatrix {
-private:
-    size_t sz;
-    TDynamicVector<T> values;    // Ненулевые значения
-    TDynamicVector<size_t> cols; // Столбцы ненулевых элементов
-    TDynamicVector<size_t> rows; // Индексы начала строк
+    TMatrixColumn<T> column(size_t j) const
+    {
+        if (j >= nCols)
+            throw out_of_range("err");
+        return TMatrixColumn<T>(pMem + j, nRows, stride);
+    }
 
-public:
-    TCSRMatrix(size_t size = 1) : sz(size), rows(sz + 1) {
-        if (sz == 0)
+    TMatrixView submatrix(size_t r0, size_t c0, size_t r, size_t c) const
+    {
+        if (r0 + r > nRows || c0 + c > nCols || r == 0 || c == 0)
             throw out_of_range("err");
-        rows[0] = 0;
+        return TMatrixView(pMem + r0 * stride + c0, r, c, stride);
     }
+};
 
-    TCSRMatrix(const TDynamicMatrix<T>& dense) : sz(dense.size()), rows(sz + 1) {
-        rows[0] = 0;
 
-        // подсчет количества ненулевых элементов
-        size_t nonZeroCount = 0;
-        for (size_t i = 0; i < sz; i++) {
+// Динамическая матрица -  шаблонная матрица на динамической памяти
+// Элементы хранятся построчно в одном непрерывном буфере; строки идут
+// с шагом ld() >= cols(), хвост строки сверх cols() не используется
+template<typename T>
+class TDynamicMatrix : public TMatrixExpr<TDynamicMatrix<T>>
+{
+protected:
+    size_t nRows, nCols, stride;
+    TDynamicVector<T> mem; // nRows * stride элементов, строка i начинается с mem[i * stride]
+
+    T* row(size_t i) noexcept { return &mem[0] + i * stride; }
+    const T* row(size_t i) const noexcept { return &mem[0] + i * stride; }
+
+    static size_t checkedSize(size_t s)
+    {
+        if (s == 0)
+            throw out_of_range("Matrix size should be greater than zero");
+        if (s > MAX_MATRIX_SIZE)
+            throw out_of_range("err");
+        return s;
+    }
+
+    // прямоугольная матрица ограничена общим числом элементов
+    static size_t checkedElements(size_t r, size_t c)
+    {
+        if (r == 0 || c == 0)
+            throw out_of_range("Matrix size should be greater than zero");
+        if (r > MAX_VECTOR_SIZE / c)
+            throw out_of_range("err");
+        return r * c;
+    }
+
+    static size_t checkedStride(size_t c, size_t ld)
+    {
+        if (ld < c)
+            throw out_of_range("err");
+        return ld;
+    }
+public:
+    typedef T value_type;
+
+    TDynamicMatrix(size_t s = 1) : nRows(checkedSize(s)), nCols(s), stride(s), mem(s * s) {}
+
+    TDynamicMatrix(size_t r, size_t c) : nRows(r), nCols(c), stride(c), mem(checkedElements(r, c)) {}
+
+    TDynamicMatrix(size_t r, size_t c, TNoInit) : nRows(r), nCols(c), stride(c), mem(checkedElements(r, c), TNoInit()) {}
+
+    // матрица с заданным шагом строк ld >= c (см. paddedLd)
+    TDynamicMatrix(size_t r, size_t c, size_t ld)
+        : nRows(r), nCols(c), stride(checkedStride(c, ld)), mem(checkedElements(r, ld)) {}
+
+    TDynamicMatrix(const TDynamicMatrix& m) = default;
+
+    TDynamicMatrix(TDynamicMatrix&& m) noexcept : nRows(m.nRows), nCols(m.nCols), stride(m.stride), mem(std::move(m.mem))
+    {
+        m.nRows = m.nCols = m.stride = 0;
+    }
+
+    // вычисление выражения
+    template<typename E>
+    TDynamicMatrix(const TMatrixExpr<E>& e) : TDynamicMatrix(e.self().rows(), e.self().cols(), TNoInit())
+    {
+        evaluate(row(0), stride, e);
+    }
+
+    TDynamicMatrix& operator=(const TDynamicMatrix& m)
+    {
+        if (this != &m) {
+            nRows = m.nRows;
+            nCols = m.nCols;
+            stride = m.stride;
+            mem = m.mem;
+        }
+        return *this;
+    }
+
+    TDynamicMatrix& operator=(TDynamicMatrix&& m) noexcept
+    {
+        if (this != &m) {
+            nRows = m.nRows;
+            nCols = m.nCols;
+            stride = m.stride;
+            mem = std::move(m.mem);
+            m.nRows = m.nCols = m.stride = 0;
+        }
+        return *this;
+    }
+
+    // шаг строк для c столбцов: строка кратна MEMORY_ALIGNMENT байт (каждая
+    // строка выровнена), а шаг, кратный 512 байт, удлиняется на строку кэша,
+    // чтобы строки матриц размера 2^k не попадали в одни наборы кэша
+    static size_t paddedLd(size_t c)
+    {
+        if (sizeof(T) > MEMORY_ALIGNMENT || MEMORY_ALIGNMENT % sizeof(T) != 0)
+            return c;
+        const size_t line = MEMORY_ALIGNMENT / sizeof(T);
+        size_t ld = (c + line - 1) / line * line;
+        if (ld * sizeof(T) % 512 == 0)
+            ld += line;
+        return ld;
+    }
+
+    template<typename E>
+    TDynamicMatrix& operator=(const TMatrixExpr<E>& e)
+    {
+        if (nRows != e.self().rows() || nCols != e.self().cols()) {
+            TDynamicMatrix tmp(e);
+            swap(*this, tmp);
+        }
+        else
+            evaluate(row(0), stride, e);
+        return *this;
+    }
+
+    // для квадратной матрицы - ее порядок, в общем случае - число строк
+    size_t size() const noexcept { return nRows; }
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    size_t ld() const noexcept { return stride; }
+    T* data() noexcept { return row(0); }
+    const T* data() const noexcept { return row(0); }
+
+    // доступ к элементу (используется выражениями)
+    T& operator()(size_t i, size_t j) noexcept { return row(i)[j]; }
+    const T& operator()(size_t i, size_t j) const noexcept { return row(i)[j]; }
+
+    // индексация
+    TMatrixRow<T> operator[](size_t ind)
+    {
+        return TMatrixRow<T>(row(ind), nCols);
+    }
+
+    TMatrixRow<const T> operator[](size_t ind) const
+    {
+        return TMatrixRow<const T>(row(ind), nCols);
+    }
+
+    // индексация с контролем
+    TMatrixRow<T> at(size_t ind)
+    {
+        if (ind >= nRows)
+            throw out_of_range("err");
+        return (*this)[ind];
+    }
+
+    TMatrixRow<const T> at(size_t ind) const
+    {
+        if (ind >= nRows)
+            throw out_of_range("err");
+        return (*this)[ind];
+    }
+
+    // представления без копирования
+    TMatrixColumn<T> column(size_t j)
+    {
+        if (j >= nCols)
+            throw out_of_range("err");
+        return TMatrixColumn<T>(row(0) + j, nRows, stride);
+    }
+
+    TMatrixColumn<const T> column(size_t j) const
+    {
+        if (j >= nCols)
+            throw out_of_range("err");
+        return TMatrixColumn<const T>(row(0) + j, nRows, stride);
+    }
+
+    TMatrixView<T> submatrix(size_t r0, size_t c0, size_t r, size_t c)
+    {
+        return view().submatrix(r0, c0, r, c);
+    }
+
+    TMatrixView<const T> submatrix(size_t r0, size_t c0, size_t r, size_t c) const
+    {
+        return view().submatrix(r0, c0, r, c);
+    }
+
+    TMatrixView<T> view() noexcept
+    {
+        return TMatrixView<T>(row(0), nRows, nCols, stride);
+    }
+
+    TMatrixView<const T> view() const noexcept
+    {
+        return TMatrixView<const T>(row(0), nRows, nCols, stride);
+    }
+
+    // res = this * v без выделения памяти; размер res - rows()
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const
+    {
+        if (nCols != v.size() || nRows != res.size())
+            throw invalid_argument("err");
+        if (&v == &res)
+            throw invalid_argument("err");
+        for (size_t i = 0; i < nRows; i++)
+            res[i] = simdDot(row(i), v.data(), nCols);
+    }
+
+    // составные присваивания - на месте, без выделения памяти
+    template<typename E>
+    TDynamicMatrix& operator+=(const TMatrixExpr<E>& e)
+    {
+        if (nRows != e.self().rows() || nCols != e.self().cols())
+            throw invalid_argument("err");
+        evaluateAdd(row(0), stride, e);
+        return *this;
+    }
+
+    template<typename E>
+    TDynamicMatrix& operator-=(const TMatrixExpr<E>& e)
+    {
+        if (nRows != e.self().rows() || nCols != e.self().cols())
+            throw invalid_argument("err");
+        evaluateSub(row(0), stride, e);
+        return *this;
+    }
+
+    TDynamicMatrix& operator*=(const T& val)
+    {
+        if (stride == nCols)
+            mem *= val;
+        else
+            for (size_t i = 0; i < nRows; i++)
+                simdMulScalar(row(i), val, row(i), nCols);
+        return *this;
+    }
+
+    TDynamicMatrix& operator/=(const T& val)
+    {
+        for (size_t i = 0; i < nRows; i++) {
+            T* a = row(i);
+            for (size_t j = 0; j < nCols; j++)
+                a[j] /= val;
+        }
+        return *this;
+    }
+
+    friend void swap(TDynamicMatrix& lhs, TDynamicMatrix& rhs) noexcept
+    {
+        std::swap(lhs.nRows, rhs.nRows);
+        std::swap(lhs.nCols, rhs.nCols);
+        std::swap(lhs.stride, rhs.stride);
+        swap(lhs.mem, rhs.mem);
+    }
+
+    // сравнение (шаг строк не учитывается)
+    bool operator==(const TDynamicMatrix& m) const noexcept
+    {
+        if (nRows != m.nRows || nCols != m.nCols)
+            return false;
+        for (size_t i = 0; i < nRows; i++)
+            if (!std::equal(row(i), row(i) + nCols, m.row(i)))
+                return false;
+        return true;
+    }
+
+    bool operator!=(const TDynamicMatrix& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    // ввод/вывод
+    friend istream& operator>>(istream& istr, TDynamicMatrix& m)
+    {
+        readText(istr, m.data(), m.nRows, m.nCols, m.stride);
+        return istr;
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& m)
+    {
+        writeText(ostr, m.data(), m.nRows, m.nCols, m.stride, true);
+        return ostr;
+    }
+};
+
+// произведения плотных матриц и представлений (data(), ld())
+template<typename X>
+TDynamicVector<typename X::value_type> denseMatVec(const X& m, const TDynamicVector<typename X::value_type>& v)
+{
+    if (m.cols() != v.size())
+        throw invalid_argument("err");
+    TDynamicVector<typename X::value_type> res(m.rows(), TNoInit());
+    for (size_t i = 0; i < m.rows(); i++)
+        res[i] = simdDot(m.data() + i * m.ld(), v.data(), m.cols());
+    return res;
+}
+
+template<typename X, typename Y>
+TDynamicMatrix<typename X::value_type> denseProduct(const X& a, const Y& b)
+{
+    if (a.cols() != b.rows())
+        throw invalid_argument("err");
+    TDynamicMatrix<typename X::value_type> res(a.rows(), b.cols(), TNoInit());
+    gemm(a.rows(), b.cols(), a.cols(), a.data(), a.ld(), b.data(), b.ld(), res.data(), res.ld(), true);
+    return res;
+}
+
+// матрично-векторные операции: (m x n) * n -> m
+template<typename T>
+TDynamicVector<T> operator*(const TDynamicMatrix<T>& m, const TDynamicVector<T>& v)
+{
+    TDynamicVector<T> res(m.rows(), TNoInit());
+    m.multiply(v, res);
+    return res;
+}
+
+// матрично-матричное произведение: (m x k) * (k x n) -> m x n
+template<typename T>
+TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& a, const TDynamicMatrix<T>& b)
+{
+    return denseProduct(a, b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Верхняя треугольная матрица
+template<typename T>
+class TUpperTriangularMatrix {
+private:
+    friend struct TMatrixIO;
+
+    size_t sz;
+    TDynamicVector<T> data; // строка i (столбцы i .. sz - 1) начинается с rowStart(i)
+
+    static const size_t blockRows = 128; // высота блока TRMM/TRSM
+
+    size_t rowStart(size_t i) const noexcept { return i * (2 * sz - i + 1) / 2; }
+    const T* row(size_t i) const noexcept { return &data[0] + rowStart(i); }
+
+    // плотная копия A[i0..i1) x [c0..sz) со знаком sign, шаг строки sz - c0
+    TDynamicVector<T> panel(size_t i0, size_t i1, size_t c0, const T& sign) const {
+        size_t w = sz - c0;
+        TDynamicVector<T> buf((i1 - i0) * w, TNoInit());
+        for (size_t i = i0; i < i1; i++)
+            simdMulScalar(row(i) + (c0 - i), sign, &buf[0] + (i - i0) * w, w);
+        return buf;
+    }
+
+    void checkDiagonal() const {
+        for (size_t i = 0; i < sz; i++)
+            if (*row(i) == T())
+                throw invalid_argument("Matrix is singular");
+    }
+
+public:
+    TUpperTriangularMatrix(size_t size = 1) : sz(size), data(sz* (sz + 1) / 2) {
+        if (sz == 0) throw out_of_range("err");
+    }
+
+    size_t size() const noexcept { return sz; }
+
+    // Индексация
+    T& at(size_t i, size_t j) {
+        if (i >= sz || j >= sz || i > j)
+            throw out_of_range("err");
+        return data[rowStart(i) + (j - i)];
+    }
+
+    const T& at(size_t i, size_t j) const {
+        if (i >= sz || j >= sz || i > j)
+            throw out_of_range("err");
+        return data[rowStart(i) + (j - i)];
+    }
+
+    // безопасное получение элемента
+    T get(size_t i, size_t j) const {
+        return (i <= j && i < sz && j < sz) ? at(i, j) : T();
+    }
+
+    // составные присваивания
+    TUpperTriangularMatrix& operator+=(const TUpperTriangularMatrix& m) {
+        if (sz != m.sz) throw invalid_argument("err");
+        data += m.data;
+        return *this;
+    }
+
+    TUpperTriangularMatrix& operator-=(const TUpperTriangularMatrix& m) {
+        if (sz != m.sz) throw invalid_argument("err");
+        data -= m.data;
+        return *this;
+    }
+
+    TUpperTriangularMatrix& operator*=(const T& val) {
+        data *= val;
+        return *this;
+    }
+
+    TUpperTriangularMatrix& operator/=(const T& val) {
+        data /= val;
+        return *this;
+    }
+
+    // умножение на вектор; multiply - без выделения памяти
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const {
+        if (sz != v.size() || sz != res.size()) throw invalid_argument("err");
+
+        for (size_t i = 0; i < sz; i++)
+            res[i] = simdDot(row(i), v.data() + i, sz - i);
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
+        TDynamicVector<T> res(sz, TNoInit());
+        multiply(v, res);
+        return res;
+    }
+
+    // обратная подстановка: x = A^-1 b; x может совпадать с b
+    void solve(const TDynamicVector<T>& b, TDynamicVector<T>& x) const {
+        if (sz != b.size() || sz != x.size()) throw invalid_argument("err");
+        checkDiagonal();
+
+        if (&x != &b)
+            std::copy(b.data(), b.data() + sz, x.data());
+        for (size_t i = sz; i-- > 0;) {
+            const T* a = row(i);
+            x[i] = (x[i] - simdDot(a + 1, x.data() + i + 1, sz - i - 1)) / a[0];
+        }
+    }
+
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const {
+        TDynamicVector<T> x(sz, TNoInit());
+        solve(b, x);
+        return x;
+    }
+
+    // TRMM: A * B. Строки делятся на блоки; внедиагональная часть блочной
+    // строки копируется в плотную панель и умножается блочным gemm,
+    // диагональный треугольник досчитывается построчно
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& b) const {
+        if (sz != b.rows()) throw invalid_argument("err");
+
+        size_t m = b.cols(), ldb = b.ld();
+        TDynamicMatrix<T> c(sz, m, TNoInit());
+        size_t ldc = c.ld();
+        for (size_t i0 = 0; i0 < sz; i0 += blockRows) {
+            size_t i1 = std::min(sz, i0 + blockRows);
+            if (i1 < sz) {
+                TDynamicVector<T> a = panel(i0, i1, i1, T(1));
+                gemm(i1 - i0, m, sz - i1, a.data(), sz - i1, b.data() + i1 * ldb, ldb,
+                    c.data() + i0 * ldc, ldc, true);
+            }
+            else
+                for (size_t i = i0; i < i1; i++)
+                    std::fill(c.data() + i * ldc, c.data() + i * ldc + m, T());
+            for (size_t i = i0; i < i1; i++) {
+                const T* a = row(i);
+                T* ci = c.data() + i * ldc;
+                for (size_t j = i; j < i1; j++) {
+                    const T* bj = b.data() + j * ldb;
+                    T aij = a[j - i];
+                    for (size_t k = 0; k < m; k++)
+                        ci[k] += aij * bj[k];
+                }
+            }
+        }
+        return c;
+    }
+
+    // TRSM: X = A^-1 B. Блоки строк снизу вверх: из блока правой части
+    // вычитается вклад уже найденных строк X (gemm с панелью -A), затем
+    // диагональный треугольник решается обратной подстановкой
+    TDynamicMatrix<T> solve(const TDynamicMatrix<T>& b) const {
+        if (sz != b.rows()) throw invalid_argument("err");
+        checkDiagonal();
+
+        TDynamicMatrix<T> x(b);
+        size_t m = x.cols(), ldx = x.ld();
+        size_t blocks = (sz + blockRows - 1) / blockRows;
+        for (size_t blk = blocks; blk-- > 0;) {
+            size_t i0 = blk * blockRows, i1 = std::min(sz, i0 + blockRows);
+            if (i1 < sz) {
+                TDynamicVector<T> a = panel(i0, i1, i1, T(-1));
+                gemm(i1 - i0, m, sz - i1, a.data(), sz - i1, x.data() + i1 * ldx, ldx,
+                    x.data() + i0 * ldx, ldx);
+            }
+            for (size_t i = i1; i-- > i0;) {
+                const T* a = row(i);
+                T* xi = x.data() + i * ldx;
+                for (size_t j = i + 1; j < i1; j++) {
+                    const T* xj = x.data() + j * ldx;
+                    T aij = a[j - i];
+                    for (size_t k = 0; k < m; k++)
+                        xi[k] -= aij * xj[k];
+                }
+                for (size_t k = 0; k < m; k++)
+                    xi[k] /= a[0];
+            }
+        }
+        return x;
+    }
+};
+
+template<typename T>
+const size_t TUpperTriangularMatrix<T>::blockRows;
+
+template<typename T>
+class TBandLU;
+
+// Ленточная матрица с kl поддиагоналями и ku наддиагоналями.
+// Хранение - массив AB из LAPACK (A(i, j) = AB(ku + i - j, j)), записанный
+// по диагоналям: диагональ j - i = ku - r занимает строку r длины sz,
+// элементы вне матрицы в начале/конце строки не используются (нули).
+// Ядра проходят только хранимые диагонали, каждую - непрерывно.
+template<typename T>
+class TBandMatrix {
+private:
+    friend class TBandLU<T>;
+    friend struct TMatrixIO;
+
+    size_t sz;
+    size_t kl, ku;
+    TDynamicVector<T> data; // (kl + ku + 1) * sz элементов
+    T zero = T();
+
+    size_t index(size_t i, size_t j) const noexcept { return (ku + i - j) * sz + j; }
+    bool inBand(size_t i, size_t j) const noexcept { return j + kl >= i && i + ku >= j; }
+
+    // this += sign * m для ленты m, вложенной в ленту этой матрицы
+    void addBand(const TBandMatrix& m, const T& sign) {
+        for (size_t r = 0; r < m.kl + m.ku + 1; r++) {
+            T* dst = &data[(r + ku - m.ku) * sz];
+            const T* src = &m.data[r * sz];
+            for (size_t j = 0; j < sz; j++)
+                dst[j] += sign * src[j];
+        }
+    }
+
+public:
+    TBandMatrix(size_t size = 1, size_t bandwidth = 1) : TBandMatrix(size, bandwidth, bandwidth) {}
+
+    TBandMatrix(size_t size, size_t lower, size_t upper) : sz(size), kl(lower), ku(upper) {
+        if (sz == 0)
+            throw out_of_range("err");
+        if (kl >= sz || ku >= sz)
+            throw out_of_range("err");
+        data = TDynamicVector<T>((kl + ku + 1) * sz);
+    }
+
+    size_t size() const noexcept { return sz; }
+    size_t getBandWidth() const noexcept { return std::max(kl, ku); }
+    size_t lowerBandWidth() const noexcept { return kl; }
+    size_t upperBandWidth() const noexcept { return ku; }
+
+    // индексация с проверкой на принадлежность ленте
+    T& at(size_t i, size_t j) {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+        if (!inBand(i, j))
+            throw out_of_range("Element outside band");
+        return data[index(i, j)];
+    }
+
+    const T& at(size_t i, size_t j) const {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+        if (!inBand(i, j))
+            return zero;
+        return data[index(i, j)];
+    }
+
+    // составные присваивания; лента m должна помещаться в ленту этой матрицы
+    TBandMatrix& operator+=(const TBandMatrix& m) {
+        if (sz != m.sz || m.kl > kl || m.ku > ku)
+            throw invalid_argument("err");
+        if (m.kl == kl && m.ku == ku)
+            data += m.data;
+        else
+            addBand(m, T(1));
+        return *this;
+    }
+
+    TBandMatrix& operator-=(const TBandMatrix& m) {
+        if (sz != m.sz || m.kl > kl || m.ku > ku)
+            throw invalid_argument("err");
+        if (m.kl == kl && m.ku == ku)
+            data -= m.data;
+        else
+            addBand(m, T(-1));
+        return *this;
+    }
+
+    TBandMatrix& operator*=(const T& val) {
+        data *= val;
+        return *this;
+    }
+
+    TBandMatrix& operator/=(const T& val) {
+        data /= val;
+        return *this;
+    }
+
+    // умножение на вектор по диагоналям: y[j - d] += AB(r, j) * x[j],
+    // d = ku - r, каждая диагональ - один векторный проход simdMulAdd;
+    // multiply - без выделения памяти
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const {
+        if (sz != v.size() || sz != res.size())
+            throw invalid_argument("err");
+        if (&v == &res)
+            throw invalid_argument("err");
+
+        std::fill(res.data(), res.data() + sz, T());
+        const T* x = v.data();
+        for (size_t r = 0; r < kl + ku + 1; r++) {
+            const T* a = &data[r * sz];
+            if (r <= ku) {
+                size_t d = ku - r; // наддиагональ: столбцы d .. sz - 1
+                simdMulAdd(a + d, x + d, res.data(), sz - d);
+            }
+            else {
+                size_t d = r - ku; // поддиагональ: столбцы 0 .. sz - d - 1
+                simdMulAdd(a, x, res.data() + d, sz - d);
+            }
+        }
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
+        TDynamicVector<T> res(sz, TNoInit());
+        multiply(v, res);
+        return res;
+    }
+};
+
+// LU-разложение ленточной матрицы с частичным выбором ведущего элемента,
+// O(n * kl * (kl + ku)). Перестановки строк расширяют верхнюю ленту до
+// kl + ku, поэтому строка i хранит столбцы i - kl .. i + kl + ku; множители
+// L остаются на месте исключенных элементов (как в LAPACK gbtrf). Для
+// трехдиагональных матриц с диагональным преобладанием выбор ведущего не
+// нужен - прогонка (метод Томаса). Разложение строится один раз, solve() -
+// O(n * (2 * kl + ku)) на каждую правую часть.
+template<typename T>
+class TBandLU {
+private:
+    size_t sz, kl, ku, w;          // w = 2 * kl + ku + 1
+    TDynamicVector<T> lu;          // элемент (i, j) - lu[i * w + j - i + kl]
+    TDynamicVector<size_t> piv;    // на шаге k строка k менялась с piv[k]
+    bool thomas;
+
+    T& el(size_t i, size_t j) noexcept { return lu[i * w + j + kl - i]; }
+    const T& el(size_t i, size_t j) const noexcept { return lu[i * w + j + kl - i]; }
+
+    static T absValue(const T& x) { return x < T() ? -x : x; }
+
+    bool diagonallyDominant() const {
+        for (size_t i = 0; i < sz; i++) {
+            T off = T();
+            if (i > 0) off += absValue(el(i, i - 1));
+            if (i + 1 < sz) off += absValue(el(i, i + 1));
+            if (absValue(el(i, i)) < off || el(i, i) == T())
+                return false;
+        }
+        return true;
+    }
+
+    // false - встретился нулевой ведущий элемент
+    bool factorThomas() {
+        for (size_t k = 0; k + 1 < sz; k++) {
+            if (el(k, k) == T())
+                return false;
+            piv[k] = k;
+            T l = el(k + 1, k) / el(k, k);
+            el(k + 1, k) = l;
+            el(k + 1, k + 1) -= l * el(k, k + 1);
+        }
+        piv[sz - 1] = sz - 1;
+        return true;
+    }
+
+    void load(const TBandMatrix<T>& a) {
+        for (size_t i = 0; i < sz; i++) {
+            size_t j0 = i > kl ? i - kl : 0, j1 = std::min(sz - 1, i + ku);
+            for (size_t j = j0; j <= j1; j++)
+                el(i, j) = a.data[a.index(i, j)];
+        }
+    }
+
+    void factorPivoting() {
+        for (size_t k = 0; k < sz; k++) {
+            size_t last = std::min(sz - 1, k + kl), lastCol = std::min(sz - 1, k + kl + ku);
+            size_t p = k;
+            for (size_t r = k + 1; r <= last; r++)
+                if (absValue(el(r, k)) > absValue(el(p, k)))
+                    p = r;
+            if (el(p, k) == T())
+                throw invalid_argument("Matrix is singular");
+            piv[k] = p;
+            if (p != k)
+                for (size_t c = k; c <= lastCol; c++)
+                    std::swap(el(k, c), el(p, c));
+            for (size_t r = k + 1; r <= last; r++) {
+                T l = el(r, k) / el(k, k);
+                el(r, k) = l;
+                if (l != T())
+                    for (size_t c = k + 1; c <= lastCol; c++)
+                        el(r, c) -= l * el(k, c);
+            }
+        }
+    }
+
+public:
+    TBandLU(const TBandMatrix<T>& a) : sz(a.sz), kl(a.kl), ku(a.ku), w(2 * a.kl + a.ku + 1),
+        lu(a.sz * (2 * a.kl + a.ku + 1)), piv(a.sz, TNoInit()), thomas(false) {
+        load(a);
+        bool tridiagonal = kl == 1 && ku == 1;
+        thomas = tridiagonal && diagonallyDominant() && factorThomas();
+        if (!thomas) {
+            if (tridiagonal)
+                load(a);
+            factorPivoting();
+        }
+        if (el(sz - 1, sz - 1) == T())
+            throw invalid_argument("Matrix is singular");
+    }
+
+    size_t size() const noexcept { return sz; }
+    size_t lowerBandWidth() const noexcept { return kl; }
+    size_t upperBandWidth() const noexcept { return ku; }
+
+    // x = A^-1 b; x может совпадать с b
+    void solve(const TDynamicVector<T>& b, TDynamicVector<T>& x) const {
+        if (b.size() != sz || x.size() != sz)
+            throw invalid_argument("err");
+        if (&x != &b)
+            std::copy(b.data(), b.data() + sz, x.data());
+        T* y = x.data();
+
+        if (thomas) {
+            for (size_t i = 1; i < sz; i++)
+                y[i] -= el(i, i - 1) * y[i - 1];
+            y[sz - 1] /= el(sz - 1, sz - 1);
+            for (size_t i = sz - 1; i-- > 0;)
+                y[i] = (y[i] - el(i, i + 1) * y[i + 1]) / el(i, i);
+            return;
+        }
+
+        // L y = P b: перестановки и исключение в порядке разложения
+        for (size_t k = 0; k < sz; k++) {
+            if (piv[k] != k)
+                std::swap(y[k], y[piv[k]]);
+            size_t last = std::min(sz - 1, k + kl);
+            for (size_t r = k + 1; r <= last; r++)
+                y[r] -= el(r, k) * y[k];
+        }
+        // U x = y
+        for (size_t i = sz; i-- > 0;) {
+            size_t lastCol = std::min(sz - 1, i + kl + ku);
+            T sum = y[i];
+            for (size_t c = i + 1; c <= lastCol; c++)
+                sum -= el(i, c) * y[c];
+            y[i] = sum / el(i, i);
+        }
+    }
+
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const {
+        TDynamicVector<T> x(sz, TNoInit());
+        solve(b, x);
+        return x;
+    }
+};
+
+// Умножение CSR матрицы на вектор y = A * x (A - n x n, rowPtr из n + 1
+// элементов). Работа делится методом merge-path: путь слияния концов строк
+// rowPtr[1..n] с номерами ненулевых элементов 0..nnz-1 режется на равные
+// отрезки, поэтому каждому потоку достается поровну строк + ненулевых,
+// а длинные строки делятся между потоками. Частичные суммы строк на
+// границах отрезков складываются после параллельной части.
+namespace spmv_detail
+{
+    // точка пути слияния на диагонали d: (число пройденных строк, ненулевых)
+    template<typename I>
+    void mergePathSearch(size_t d, const I* rowEnd, size_t n, size_t nnz, size_t& i, size_t& k)
+    {
+        size_t lo = d > nnz ? d - nnz : 0, hi = std::min(d, n);
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (rowEnd[mid] < d - mid)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        i = lo;
+        k = d - lo;
+    }
+
+    template<typename T, typename I>
+    void spmvSerial(size_t n, const I* rowPtr, const I* colIdx, const T* vals, const T* x, T* y)
+    {
+        for (size_t i = 0; i < n; i++) {
+            T sum = T();
+            for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; k++)
+                sum += vals[k] * x[colIdx[k]];
+            y[i] = sum;
+        }
+    }
+}
+
+template<typename T, typename I>
+void spmv(size_t n, const I* rowPtr, const I* colIdx, const T* vals, const T* x, T* y)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    size_t threads = pool.threadCount();
+    size_t nnz = rowPtr[n];
+    size_t total = n + nnz;
+    if (threads == 1 || total <= 32768) {
+        spmv_detail::spmvSerial(n, rowPtr, colIdx, vals, x, y);
+        return;
+    }
+
+    size_t parts = std::min(threads, total / 4096);
+    size_t chunk = (total + parts - 1) / parts;
+    std::vector<size_t> carryRow(parts);
+    std::vector<T> carryVal(parts);
+    pool.parallelFor(parts, [&](size_t t) {
+        size_t i, k, iEnd, kEnd;
+        spmv_detail::mergePathSearch(std::min(t * chunk, total), rowPtr + 1, n, nnz, i, k);
+        spmv_detail::mergePathSearch(std::min((t + 1) * chunk, total), rowPtr + 1, n, nnz, iEnd, kEnd);
+        T sum = T();
+        for (; i < iEnd; i++) {
+            for (; k < rowPtr[i + 1]; k++)
+                sum += vals[k] * x[colIdx[k]];
+            y[i] = sum;
+            sum = T();
+        }
+        // начало строки iEnd, которую закончит следующий отрезок
+        for (; k < kEnd; k++)
+            sum += vals[k] * x[colIdx[k]];
+        carryRow[t] = iEnd;
+        carryVal[t] = sum;
+    });
+    for (size_t t = 0; t + 1 < parts; t++)
+        if (carryRow[t] < n)
+            y[carryRow[t]] += carryVal[t];
+}
+
+// Невладеющее представление CSR матрицы поверх готовых массивов (например,
+// отображенного в память файла, см. tio.h)
+template<typename T, typename I = uint32_t>
+class TCSRView {
+private:
+    size_t sz;
+    const I* rowPtr;
+    const I* colIdx;
+    const T* vals;
+
+public:
+    TCSRView(size_t size, const I* rows, const I* cols, const T* values) noexcept
+        : sz(size), rowPtr(rows), colIdx(cols), vals(values) {}
+
+    size_t size() const noexcept { return sz; }
+    size_t nonZeros() const noexcept { return rowPtr[sz]; }
+    const I* rowStarts() const noexcept { return rowPtr; }
+    const I* columns() const noexcept { return colIdx; }
+    const T* values() const noexcept { return vals; }
+
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const {
+        if (sz != v.size() || sz != res.size())
+            throw invalid_argument("err");
+        if (&v == &res)
+            throw invalid_argument("err");
+        spmv(sz, rowPtr, colIdx, vals, v.data(), res.data());
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
+        TDynamicVector<T> res(sz, TNoInit());
+        multiply(v, res);
+        return res;
+    }
+};
+
+// CSR матрица
+// I - беззнаковый тип индексов столбцов и начал строк; по умолчанию 32 бита,
+// что вдвое сокращает объем индексов. Размер и число ненулевых элементов
+// должны помещаться в I, иначе бросается out_of_range.
+
+template<typename T, typename I = uint32_t>
+class TCSRBuilder;
+
+template<typename T, typename I = uint32_t>
+class TSellMatrix;
+
+template<typename T, typename I = uint32_t>
+class TCSRMatrix {
+private:
+    static_assert(std::is_integral<I>::value && std::is_unsigned<I>::value,
+        "TCSRMatrix index type should be an unsigned integer");
+    friend class TCSRBuilder<T, I>;
+    friend class TSellMatrix<T, I>;
+    friend struct TMatrixIO;
+
+    size_t sz;
+    TDynamicVector<T> values; // Ненулевые значения
+    TDynamicVector<I> cols;   // Столбцы ненулевых элементов
+    TDynamicVector<I> rows;   // Индексы начала строк
+
+    static size_t checkedIndex(size_t x) {
+        if (x > std::numeric_limits<I>::max())
+            throw out_of_range("err");
+        return x;
+    }
+
+    bool sameStructure(const TCSRMatrix& m) const {
+        if (sz != m.sz)
+            return false;
+        for (size_t i = 0; i <= sz; i++)
+            if (rows[i] != m.rows[i])
+                return false;
+        for (size_t k = 0; k < rows[sz]; k++)
+            if (cols[k] != m.cols[k])
+                return false;
+        return true;
+    }
+
+    // this += sign * m; при разной структуре строки сливаются
+    TCSRMatrix& addScaled(const TCSRMatrix& m, const T& sign) {
+        if (sz != m.sz)
+            throw invalid_argument("err");
+        if (sameStructure(m)) {
+            for (size_t k = 0; k < rows[sz]; k++)
+                values[k] += sign * m.values[k];
+            return *this;
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < sz; i++) {
+            size_t a = rows[i], b = m.rows[i];
+            while (a < rows[i + 1] || b < m.rows[i + 1]) {
+                if (b == m.rows[i + 1] || (a < rows[i + 1] && cols[a] < m.cols[b])) a++;
+                else if (a == rows[i + 1] || m.cols[b] < cols[a]) b++;
+                else { a++; b++; }
+                count++;
+            }
+        }
+
+        checkedIndex(count);
+        TDynamicVector<T> newValues(count ? count : 1, TNoInit());
+        TDynamicVector<I> newCols(count ? count : 1, TNoInit());
+        TDynamicVector<I> newRows(sz + 1, TNoInit());
+        newRows[0] = 0;
+        size_t idx = 0;
+        for (size_t i = 0; i < sz; i++) {
+            size_t a = rows[i], b = m.rows[i];
+            while (a < rows[i + 1] || b < m.rows[i + 1]) {
+                if (b == m.rows[i + 1] || (a < rows[i + 1] && cols[a] < m.cols[b])) {
+                    newValues[idx] = values[a];
+                    newCols[idx] = cols[a++];
+                }
+                else if (a == rows[i + 1] || m.cols[b] < cols[a]) {
+                    newValues[idx] = sign * m.values[b];
+                    newCols[idx] = m.cols[b++];
+                }
+                else {
+                    newValues[idx] = values[a++] + sign * m.values[b];
+                    newCols[idx] = m.cols[b++];
+                }
+                idx++;
+            }
+            newRows[i + 1] = static_cast<I>(idx);
+        }
+        values = std::move(newValues);
+        cols = std::move(newCols);
+        rows = std::move(newRows);
+        return *this;
+    }
+
+public:
+    TCSRMatrix(size_t size = 1) : sz(checkedIndex(size)), rows(sz + 1) {
+        if (sz == 0)
+            throw out_of_range("err");
+        rows[0] = 0;
+    }
+
+    TCSRMatrix(const TDynamicMatrix<T>& dense) : sz(checkedIndex(dense.size())), rows(sz + 1) {
+        if (dense.rows() != dense.cols())
+            throw invalid_argument("err");
+        rows[0] = 0;
+
+        // подсчет количества ненулевых элементов
+        size_t nonZeroCount = 0;
+        for (size_t i = 0; i < sz; i++) {
             for (size_t j = 0; j < sz; j++) {
                 if (dense[i][j] != T()) {
                     nonZeroCount++;
@@ -470,8 +1684,9 @@ public:
         }
 
         // выделяем память
-        values = TDynamicVector<T>(nonZeroCount);
-        cols = TDynamicVector<size_t>(nonZeroCount);
+        checkedIndex(nonZeroCount);
+        values = TDynamicVector<T>(nonZeroCount ? nonZeroCount : 1, TNoInit());
+        cols = TDynamicVector<I>(nonZeroCount ? nonZeroCount : 1, TNoInit());
 
         // заполняем данные
         size_t idx = 0;
@@ -479,30 +1694,41 @@ public:
             for (size_t j = 0; j < sz; j++) {
                 if (dense[i][j] != T()) {
                     values[idx] = dense[i][j];
-                    cols[idx] = j;
+                    cols[idx] = static_cast<I>(j);
                     idx++;
                 }
             }
-            rows[i + 1] = idx;
+            rows[i + 1] = static_cast<I>(idx);
         }
     }
 
+    TCSRMatrix(const TCSRBuilder<T, I>& b) : TCSRMatrix(b.build()) {}
+
+    // перемещение передает массивы без копирования
+    TCSRMatrix(const TCSRMatrix&) = default;
+    TCSRMatrix(TCSRMatrix&&) noexcept = default;
+    TCSRMatrix& operator=(const TCSRMatrix&) = default;
+    TCSRMatrix& operator=(TCSRMatrix&&) noexcept = default;
+
     size_t size() const noexcept { return sz; }
-    size_t nonZeros() const noexcept { return values.size(); }
+    size_t nonZeros() const noexcept { return rows[sz]; }
 
-    // умножение на вектор
-    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
-        if (sz != v.size())
+    TCSRView<T, I> view() const noexcept {
+        return TCSRView<T, I>(sz, rows.data(), cols.data(), values.data());
+    }
+
+    // умножение на вектор; multiply - без выделения памяти
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const {
+        if (sz != v.size() || sz != res.size())
+            throw invalid_argument("err");
+        if (&v == &res)
             throw invalid_argument("err");
+        spmv(sz, rows.data(), cols.data(), values.data(), v.data(), res.data());
+    }
 
-        TDynamicVector<T> res(sz);
-        for (size_t i = 0; i < sz; i++) {
-            T sum = T();
-            for (size_t j = rows[i]; j < rows[i + 1]; j++) {
-                sum += values[j] * v[cols[j]];
-            }
-            res[i] = sum;
-        }
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
+        TDynamicVector<T> res(sz, TNoInit());
+        multiply(v, res);
         return res;
     }
 
@@ -519,35 +1745,273 @@ public:
         return T();
     }
 
-    // установка элемента
+    // установка элемента: O(nonZeros()) на вызов; для сборки матрицы
+    // из многих элементов следует использовать TCSRBuilder
     void set(size_t i, size_t j, const T& value) {
         if (i >= sz || j >= sz)
             throw out_of_range("err");
 
-        // создаем временную плотную матрицу
-        TDynamicMatrix<T> dense(sz);
+        size_t k = rows[i];
+        while (k < rows[i + 1] && cols[k] < j)
+            k++;
+        bool found = k < rows[i + 1] && cols[k] == j;
+        if (found && value != T()) {
+            values[k] = value;
+            return;
+        }
+        if (!found && value == T())
+            return;
+
+        // вставка или удаление элемента k со сдвигом хвоста
+        size_t nnz = rows[sz];
+        size_t count = checkedIndex(found ? nnz - 1 : nnz + 1);
+        TDynamicVector<T> newValues(count ? count : 1, TNoInit());
+        TDynamicVector<I> newCols(count ? count : 1, TNoInit());
+        std::copy(&values[0], &values[0] + k, &newValues[0]);
+        std::copy(&cols[0], &cols[0] + k, &newCols[0]);
+        if (found) {
+            std::copy(&values[0] + k + 1, &values[0] + nnz, &newValues[0] + k);
+            std::copy(&cols[0] + k + 1, &cols[0] + nnz, &newCols[0] + k);
+            for (size_t r = i + 1; r <= sz; r++)
+                rows[r]--;
+        }
+        else {
+            newValues[k] = value;
+            newCols[k] = static_cast<I>(j);
+            std::copy(&values[0] + k, &values[0] + nnz, &newValues[0] + k + 1);
+            std::copy(&cols[0] + k, &cols[0] + nnz, &newCols[0] + k + 1);
+            for (size_t r = i + 1; r <= sz; r++)
+                rows[r]++;
+        }
+        values = std::move(newValues);
+        cols = std::move(newCols);
+    }
+
+    // составные присваивания; при одинаковой структуре - на месте
+    TCSRMatrix& operator+=(const TCSRMatrix& m) {
+        return addScaled(m, T(1));
+    }
+
+    TCSRMatrix& operator-=(const TCSRMatrix& m) {
+        return addScaled(m, T(-1));
+    }
+
+    TCSRMatrix& operator*=(const T& val) {
+        values *= val;
+        return *this;
+    }
+
+    TCSRMatrix& operator/=(const T& val) {
+        values /= val;
+        return *this;
+    }
+
+};
+// Построитель CSR матрицы по тройкам (i, j, v) в произвольном порядке.
+// Повторные элементы суммируются, нулевые суммы отбрасываются. build()
+// раскладывает тройки по строкам подсчетом и сортирует каждую строку по
+// столбцам: O(nnz log nnz) вместо O(n^2) на каждый set()
+template<typename T, typename I>
+class TCSRBuilder {
+private:
+    size_t sz;
+    std::vector<I> rowIdx, colIdx;
+    std::vector<T> vals;
+
+public:
+    TCSRBuilder(size_t size = 1) : sz(TCSRMatrix<T, I>::checkedIndex(size)) {
+        if (sz == 0)
+            throw out_of_range("err");
+    }
+
+    size_t size() const noexcept { return sz; }
+    size_t entries() const noexcept { return vals.size(); }
+
+    void reserve(size_t n) {
+        rowIdx.reserve(n);
+        colIdx.reserve(n);
+        vals.reserve(n);
+    }
+
+    void add(size_t i, size_t j, const T& value) {
+        if (i >= sz || j >= sz)
+            throw out_of_range("err");
+        rowIdx.push_back(static_cast<I>(i));
+        colIdx.push_back(static_cast<I>(j));
+        vals.push_back(value);
+    }
+
+    void clear() noexcept {
+        rowIdx.clear();
+        colIdx.clear();
+        vals.clear();
+    }
+
+    TCSRMatrix<T, I> build() const {
+        TCSRMatrix<T, I> res(sz);
+        size_t n = vals.size();
 
-        for (size_t row = 0; row < sz; row++) {
-            for (size_t col = 0; col < sz; col++) {
-                dense[row][col] = this->at(row, col);
+        // раскладка по строкам подсчетом, порядок добавления сохраняется
+        std::vector<size_t> start(sz + 1, 0);
+        for (size_t k = 0; k < n; k++)
+            start[rowIdx[k] + 1]++;
+        for (size_t i = 0; i < sz; i++)
+            start[i + 1] += start[i];
+        std::vector<size_t> order(n);
+        {
+            std::vector<size_t> pos(start.begin(), start.end() - 1);
+            for (size_t k = 0; k < n; k++)
+                order[pos[rowIdx[k]]++] = k;
+        }
+
+        TDynamicVector<T> values(n ? n : 1, TNoInit());
+        TDynamicVector<I> cols(n ? n : 1, TNoInit());
+        size_t idx = 0;
+        res.rows[0] = 0;
+        for (size_t i = 0; i < sz; i++) {
+            auto first = order.begin() + start[i], last = order.begin() + start[i + 1];
+            std::stable_sort(first, last,
+                [this](size_t a, size_t b) { return colIdx[a] < colIdx[b]; });
+            for (auto it = first; it != last;) {
+                size_t j = colIdx[*it];
+                T sum = vals[*it];
+                for (++it; it != last && colIdx[*it] == j; ++it)
+                    sum += vals[*it];
+                if (sum != T()) {
+                    values[idx] = sum;
+                    cols[idx] = j;
+                    idx++;
+                }
             }
+            res.rows[i + 1] = static_cast<I>(TCSRMatrix<T, I>::checkedIndex(idx));
         }
+        res.values = std::move(values);
+        res.cols = std::move(cols);
+        return res;
+    }
+};
 
-        dense[i][j] = value;
+// Матрица в формате SELL-C-sigma (срезанный ELLPACK), C = 8. Строки внутри
+// окон из sigma строк упорядочены по убыванию длины, затем группируются
+// в срезы по 8 строк; срез хранится по столбцам шириной в самую длинную
+// свою строку, короткие строки дополнены нулями. При умножении на вектор
+// срез считается целиком, по 8 строк сразу со сбором x (simdSell8).
+// Выгодно при близких длинах строк (МКЭ); при сильно разных длинах растет
+// доля дополнения (см. storedElements()).
+template<typename T, typename I>
+class TSellMatrix {
+private:
+    static const size_t C = 8;
+
+    size_t sz, nnz;
+    TDynamicVector<T> values;      // срез s: values[chunks[s] + k * C + r]
+    TDynamicVector<I> cols;        // столбцы, для дополнения - 0
+    TDynamicVector<size_t> chunks; // начала срезов, nChunks + 1 элементов
+    TDynamicVector<size_t> perm;   // строка r среза s - исходная строка perm[s * C + r] (sz - пустая)
+
+    void multiplyChunks(size_t s0, size_t s1, const T* x, T* y) const {
+        T acc[C];
+        for (size_t s = s0; s < s1; s++) {
+            size_t w = (chunks[s + 1] - chunks[s]) / C;
+            const T* v = values.data() + chunks[s];
+            const I* c = cols.data() + chunks[s];
+            if (std::is_same<I, uint32_t>::value && sz <= 0x7FFFFFFF)
+                simdSell8(v, reinterpret_cast<const uint32_t*>(c), w, x, acc);
+            else
+                simd_detail::sell8Scalar(v, c, w, x, acc);
+            for (size_t r = 0; r < C; r++)
+                if (perm[s * C + r] < sz)
+                    y[perm[s * C + r]] = acc[r];
+        }
+    }
+
+public:
+    static size_t chunkHeight() noexcept { return C; }
 
-        // пересоздание CSR матрицы
-        *this = TCSRMatrix<T>(dense);
+    TSellMatrix(const TCSRMatrix<T, I>& m, size_t sigma = 256) : sz(m.sz), nnz(m.nonZeros()),
+        chunks((m.sz + C - 1) / C + 1, TNoInit()), perm((m.sz + C - 1) / C * C, TNoInit()) {
+        if (sigma == 0)
+            throw out_of_range("err");
+        size_t nChunks = chunks.size() - 1;
+        for (size_t i = 0; i < perm.size(); i++)
+            perm[i] = i;
+        auto len = [&](size_t i) { return i < sz ? size_t(m.rows[i + 1] - m.rows[i]) : size_t(0); };
+        for (size_t w0 = 0; w0 < sz; w0 += sigma) {
+            size_t w1 = std::min(sz, w0 + sigma);
+            std::stable_sort(&perm[0] + w0, &perm[0] + w1,
+                [&](size_t a, size_t b) { return len(a) > len(b); });
+        }
+        for (size_t i = sz; i < perm.size(); i++)
+            perm[i] = sz;
+
+        chunks[0] = 0;
+        for (size_t s = 0; s < nChunks; s++) {
+            size_t w = 0;
+            for (size_t r = 0; r < C; r++)
+                w = std::max(w, len(perm[s * C + r]));
+            chunks[s + 1] = chunks[s] + w * C;
+        }
+        size_t total = chunks[nChunks];
+        values = TDynamicVector<T>(total ? total : 1, TNoInit());
+        cols = TDynamicVector<I>(total ? total : 1, TNoInit());
+        for (size_t s = 0; s < nChunks; s++) {
+            size_t w = (chunks[s + 1] - chunks[s]) / C;
+            for (size_t r = 0; r < C; r++) {
+                size_t i = perm[s * C + r], l = len(i);
+                for (size_t k = 0; k < w; k++) {
+                    size_t p = chunks[s] + k * C + r;
+                    if (k < l) {
+                        values[p] = m.values[m.rows[i] + k];
+                        cols[p] = m.cols[m.rows[i] + k];
+                    }
+                    else {
+                        values[p] = T();
+                        cols[p] = 0;
+                    }
+                }
+            }
+        }
     }
 
-    // оператор присваивания
-    TCSRMatrix& operator=(const TCSRMatrix& other) {
-        if (this != &other) {
-            sz = other.sz;
-            values = other.values;
-            cols = other.cols;
-            rows = other.rows;
+    size_t size() const noexcept { return sz; }
+    size_t nonZeros() const noexcept { return nnz; }
+    size_t storedElements() const noexcept { return chunks[chunks.size() - 1]; }
+
+    // умножение на вектор; срезы делятся между потоками поровну по объему
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const {
+        if (sz != v.size() || sz != res.size())
+            throw invalid_argument("err");
+        if (&v == &res)
+            throw invalid_argument("err");
+
+        size_t nChunks = chunks.size() - 1;
+        TThreadPool& pool = TThreadPool::instance();
+        size_t threads = pool.threadCount();
+        size_t total = storedElements() + sz;
+        if (threads == 1 || total <= 32768) {
+            multiplyChunks(0, nChunks, v.data(), res.data());
+            return;
         }
-        return *this;
+
+        size_t parts = std::min(threads, total / 4096);
+        const size_t* first = &chunks[0];
+        pool.parallelFor(parts, [&](size_t t) {
+            size_t s0 = std::lower_bound(first, first + nChunks, storedElements() * t / parts) - first;
+            size_t s1 = std::lower_bound(first, first + nChunks, storedElements() * (t + 1) / parts) - first;
+            if (t + 1 == parts)
+                s1 = nChunks;
+            multiplyChunks(s0, s1, v.data(), res.data());
+        });
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
+        TDynamicVector<T> res(sz, TNoInit());
+        multiply(v, res);
+        return res;
     }
 };
-#endif
\ No newline at end of file
+
+template<typename T, typename I>
+const size_t TSellMatrix<T, I>::C;
+
+#endif
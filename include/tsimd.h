@@ -0,0 +1,545 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TSIMD_H__
+#define __TSIMD_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+// Векторные ядра поэлементной арифметики с выбором набора инструкций
+// во время выполнения (CPUID): SSE2, AVX2 или AVX-512. Ядра есть для
+// float, double, int32_t и int64_t; для остальных типов (в том числе
+// беззнаковых и целых того же размера, но другого типа, например long long
+// при int64_t = long) используется обычный цикл. Уровень можно ограничить переменной окружения
+// TMATRIX_SIMD (none, sse2, avx2, avx512) или функцией setSimdLevel().
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TSIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TSIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define TSIMD_TARGET(isa)
+#endif
+
+enum TSimdLevel
+{
+    SIMD_NONE = 0,
+    SIMD_SSE2 = 1,
+    SIMD_AVX2 = 2,
+    SIMD_AVX512 = 3
+};
+
+// таблица ядер для одного типа и одного набора инструкций
+template<typename T>
+struct TSimdKernels
+{
+    void (*add)(const T* a, const T* b, T* r, size_t n);
+    void (*sub)(const T* a, const T* b, T* r, size_t n);
+    void (*addScalar)(const T* a, T val, T* r, size_t n);
+    void (*subScalar)(const T* a, T val, T* r, size_t n);
+    void (*mulScalar)(const T* a, T val, T* r, size_t n);
+    T (*dot)(const T* a, const T* b, size_t n);
+    void (*mulAdd)(const T* a, const T* b, T* r, size_t n);
+    void (*axpy)(const T* a, T val, const T* b, T* r, size_t n);
+};
+
+namespace simd_detail
+{
+    // скалярные ядра - запасной вариант
+    template<typename T>
+    struct Scalar
+    {
+        static void add(const T* a, const T* b, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] = a[i] + b[i];
+        }
+        static void sub(const T* a, const T* b, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] = a[i] - b[i];
+        }
+        static void addScalar(const T* a, T val, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] = a[i] + val;
+        }
+        static void subScalar(const T* a, T val, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] = a[i] - val;
+        }
+        static void mulScalar(const T* a, T val, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] = a[i] * val;
+        }
+        static T dot(const T* a, const T* b, size_t n)
+        {
+            T res = T();
+            for (size_t i = 0; i < n; i++)
+                res += a[i] * b[i];
+            return res;
+        }
+        static void mulAdd(const T* a, const T* b, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] += a[i] * b[i];
+        }
+        static void axpy(const T* a, T val, const T* b, T* r, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                r[i] = a[i] + val * b[i];
+        }
+    };
+
+#ifdef TSIMD_X86
+    inline void cpuid(int leaf, int sub, unsigned regs[4])
+    {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuidex(r, leaf, sub);
+        for (int i = 0; i < 4; i++)
+            regs[i] = static_cast<unsigned>(r[i]);
+#else
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        __get_cpuid_count(leaf, sub, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+    }
+
+    inline unsigned long long xgetbv0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+    }
+
+    inline TSimdLevel detectLevel()
+    {
+        unsigned r[4];
+        cpuid(0, 0, r);
+        unsigned maxLeaf = r[0];
+        cpuid(1, 0, r);
+        if (!(r[3] & (1u << 26)))                     // SSE2
+            return SIMD_NONE;
+        bool osxsave = (r[2] & (1u << 27)) != 0;
+        if (!osxsave || maxLeaf < 7)
+            return SIMD_SSE2;
+        unsigned long long xcr0 = xgetbv0();
+        if ((xcr0 & 0x6) != 0x6)                      // состояние XMM и YMM
+            return SIMD_SSE2;
+        cpuid(7, 0, r);
+        if (!(r[1] & (1u << 5)))                      // AVX2
+            return SIMD_SSE2;
+        bool avx512 = (r[1] & (1u << 16)) && (r[1] & (1u << 17));   // AVX-512F и DQ
+        if (!avx512 || (xcr0 & 0xE6) != 0xE6)         // + opmask и ZMM
+            return SIMD_AVX2;
+        return SIMD_AVX512;
+    }
+#else
+    inline TSimdLevel detectLevel() { return SIMD_NONE; }
+#endif
+
+    inline TSimdLevel supportedLevel()
+    {
+        static const TSimdLevel lvl = detectLevel();
+        return lvl;
+    }
+
+    inline TSimdLevel initialLevel()
+    {
+        TSimdLevel lvl = supportedLevel();
+        if (const char* env = std::getenv("TMATRIX_SIMD")) {
+            TSimdLevel req = lvl;
+            if (std::strcmp(env, "none") == 0) req = SIMD_NONE;
+            else if (std::strcmp(env, "sse2") == 0) req = SIMD_SSE2;
+            else if (std::strcmp(env, "avx2") == 0) req = SIMD_AVX2;
+            else if (std::strcmp(env, "avx512") == 0) req = SIMD_AVX512;
+            if (req < lvl)
+                lvl = req;
+        }
+        return lvl;
+    }
+
+    inline std::atomic<int>& currentLevel()
+    {
+        static std::atomic<int> lvl(initialLevel());
+        return lvl;
+    }
+
+#ifdef TSIMD_X86
+#define TSIMD_BINARY(name, isa, T, W, PT, LOAD, STORE, VOP, SOP)                        \
+    TSIMD_TARGET(isa) inline void name(const T* a, const T* b, T* r, size_t n)         \
+    {                                                                                   \
+        size_t i = 0;                                                                   \
+        for (; i + W <= n; i += W)                                                      \
+            STORE((PT*)(r + i), VOP(LOAD((const PT*)(a + i)), LOAD((const PT*)(b + i)))); \
+        for (; i < n; i++)                                                              \
+            r[i] = a[i] SOP b[i];                                                       \
+    }
+
+#define TSIMD_SCALAR(name, isa, T, VT, W, PT, LOAD, STORE, SET1, VOP, SOP)              \
+    TSIMD_TARGET(isa) inline void name(const T* a, T val, T* r, size_t n)              \
+    {                                                                                   \
+        const VT s = SET1(val);                                                         \
+        size_t i = 0;                                                                   \
+        for (; i + W <= n; i += W)                                                      \
+            STORE((PT*)(r + i), VOP(LOAD((const PT*)(a + i)), s));                      \
+        for (; i < n; i++)                                                              \
+            r[i] = a[i] SOP val;                                                        \
+    }
+
+#define TSIMD_DOT(name, isa, T, VT, W, PT, LOAD, STORE, ZERO, VADD, VMUL)               \
+    TSIMD_TARGET(isa) inline T name(const T* a, const T* b, size_t n)                  \
+    {                                                                                   \
+        VT acc0 = ZERO(), acc1 = ZERO();                                                \
+        size_t i = 0;                                                                   \
+        for (; i + 2 * W <= n; i += 2 * W) {                                            \
+            acc0 = VADD(acc0, VMUL(LOAD((const PT*)(a + i)), LOAD((const PT*)(b + i)))); \
+            acc1 = VADD(acc1, VMUL(LOAD((const PT*)(a + i + W)), LOAD((const PT*)(b + i + W)))); \
+        }                                                                               \
+        for (; i + W <= n; i += W)                                                      \
+            acc0 = VADD(acc0, VMUL(LOAD((const PT*)(a + i)), LOAD((const PT*)(b + i)))); \
+        acc0 = VADD(acc0, acc1);                                                        \
+        T lanes[W];                                                                     \
+        STORE((PT*)lanes, acc0);                                                        \
+        T res = T();                                                                    \
+        for (size_t k = 0; k < W; k++)                                                  \
+            res += lanes[k];                                                            \
+        for (; i < n; i++)                                                              \
+            res += a[i] * b[i];                                                         \
+        return res;                                                                     \
+    }
+
+#define TSIMD_MULADD(name, isa, T, W, PT, LOAD, STORE, VADD, VMUL)                     \
+    TSIMD_TARGET(isa) inline void name(const T* a, const T* b, T* r, size_t n)         \
+    {                                                                                   \
+        size_t i = 0;                                                                   \
+        for (; i + W <= n; i += W)                                                      \
+            STORE((PT*)(r + i), VADD(LOAD((const PT*)(r + i)),                          \
+                VMUL(LOAD((const PT*)(a + i)), LOAD((const PT*)(b + i)))));             \
+        for (; i < n; i++)                                                              \
+            r[i] += a[i] * b[i];                                                        \
+    }
+
+#define TSIMD_AXPY(name, isa, T, VT, W, PT, LOAD, STORE, SET1, VADD, VMUL)             \
+    TSIMD_TARGET(isa) inline void name(const T* a, T val, const T* b, T* r, size_t n)  \
+    {                                                                                   \
+        const VT s = SET1(val);                                                         \
+        size_t i = 0;                                                                   \
+        for (; i + W <= n; i += W)                                                      \
+            STORE((PT*)(r + i), VADD(LOAD((const PT*)(a + i)),                          \
+                VMUL(s, LOAD((const PT*)(b + i)))));                                    \
+        for (; i < n; i++)                                                              \
+            r[i] = a[i] + val * b[i];                                                   \
+    }
+
+#define TSIMD_ARITH(prefix, isa, T, VT, W, PT, LOAD, STORE, SET1, VADD, VSUB)           \
+    TSIMD_BINARY(prefix##Add, isa, T, W, PT, LOAD, STORE, VADD, +)                      \
+    TSIMD_BINARY(prefix##Sub, isa, T, W, PT, LOAD, STORE, VSUB, -)                      \
+    TSIMD_SCALAR(prefix##AddScalar, isa, T, VT, W, PT, LOAD, STORE, SET1, VADD, +)      \
+    TSIMD_SCALAR(prefix##SubScalar, isa, T, VT, W, PT, LOAD, STORE, SET1, VSUB, -)
+
+#define TSIMD_MUL(prefix, isa, T, VT, W, PT, LOAD, STORE, SET1, ZERO, VADD, VMUL)       \
+    TSIMD_SCALAR(prefix##MulScalar, isa, T, VT, W, PT, LOAD, STORE, SET1, VMUL, *)      \
+    TSIMD_DOT(prefix##Dot, isa, T, VT, W, PT, LOAD, STORE, ZERO, VADD, VMUL)            \
+    TSIMD_MULADD(prefix##MulAdd, isa, T, W, PT, LOAD, STORE, VADD, VMUL)               \
+    TSIMD_AXPY(prefix##Axpy, isa, T, VT, W, PT, LOAD, STORE, SET1, VADD, VMUL)
+
+    // SSE2: целочисленного умножения нет, оно остается скалярным
+    TSIMD_ARITH(sse2F, "sse2", float, __m128, 4, float, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_add_ps, _mm_sub_ps)
+    TSIMD_MUL(sse2F, "sse2", float, __m128, 4, float, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_setzero_ps, _mm_add_ps, _mm_mul_ps)
+    TSIMD_ARITH(sse2D, "sse2", double, __m128d, 2, double, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_add_pd, _mm_sub_pd)
+    TSIMD_MUL(sse2D, "sse2", double, __m128d, 2, double, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_setzero_pd, _mm_add_pd, _mm_mul_pd)
+    TSIMD_ARITH(sse2I32, "sse2", int32_t, __m128i, 4, __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_set1_epi32, _mm_add_epi32, _mm_sub_epi32)
+    TSIMD_ARITH(sse2I64, "sse2", int64_t, __m128i, 2, __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_set1_epi64x, _mm_add_epi64, _mm_sub_epi64)
+
+    // AVX2: 64-битного умножения нет, оно остается скалярным
+    TSIMD_ARITH(avx2F, "avx2", float, __m256, 8, float, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_add_ps, _mm256_sub_ps)
+    TSIMD_MUL(avx2F, "avx2", float, __m256, 8, float, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_setzero_ps, _mm256_add_ps, _mm256_mul_ps)
+    TSIMD_ARITH(avx2D, "avx2", double, __m256d, 4, double, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_add_pd, _mm256_sub_pd)
+    TSIMD_MUL(avx2D, "avx2", double, __m256d, 4, double, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_setzero_pd, _mm256_add_pd, _mm256_mul_pd)
+    TSIMD_ARITH(avx2I32, "avx2", int32_t, __m256i, 8, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_set1_epi32, _mm256_add_epi32, _mm256_sub_epi32)
+    TSIMD_MUL(avx2I32, "avx2", int32_t, __m256i, 8, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_set1_epi32, _mm256_setzero_si256, _mm256_add_epi32, _mm256_mullo_epi32)
+    TSIMD_ARITH(avx2I64, "avx2", int64_t, __m256i, 4, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_set1_epi64x, _mm256_add_epi64, _mm256_sub_epi64)
+
+    // AVX-512 (F + DQ)
+#define TSIMD_AVX512 "avx512f,avx512dq"
+    TSIMD_ARITH(avx512F, TSIMD_AVX512, float, __m512, 16, float, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps, _mm512_add_ps, _mm512_sub_ps)
+    TSIMD_MUL(avx512F, TSIMD_AVX512, float, __m512, 16, float, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps, _mm512_setzero_ps, _mm512_add_ps, _mm512_mul_ps)
+    TSIMD_ARITH(avx512D, TSIMD_AVX512, double, __m512d, 8, double, _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd, _mm512_add_pd, _mm512_sub_pd)
+    TSIMD_MUL(avx512D, TSIMD_AVX512, double, __m512d, 8, double, _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd, _mm512_setzero_pd, _mm512_add_pd, _mm512_mul_pd)
+    TSIMD_ARITH(avx512I32, TSIMD_AVX512, int32_t, __m512i, 16, void, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_set1_epi32, _mm512_add_epi32, _mm512_sub_epi32)
+    TSIMD_MUL(avx512I32, TSIMD_AVX512, int32_t, __m512i, 16, void, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_set1_epi32, _mm512_setzero_si512, _mm512_add_epi32, _mm512_mullo_epi32)
+    TSIMD_ARITH(avx512I64, TSIMD_AVX512, int64_t, __m512i, 8, void, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_set1_epi64, _mm512_add_epi64, _mm512_sub_epi64)
+    TSIMD_MUL(avx512I64, TSIMD_AVX512, int64_t, __m512i, 8, void, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_set1_epi64, _mm512_setzero_si512, _mm512_add_epi64, _mm512_mullo_epi64)
+#undef TSIMD_AVX512
+
+#undef TSIMD_MUL
+#undef TSIMD_ARITH
+#undef TSIMD_AXPY
+#undef TSIMD_MULADD
+#undef TSIMD_DOT
+#undef TSIMD_SCALAR
+#undef TSIMD_BINARY
+
+#define TSIMD_TABLE(prefix, T) \
+    { prefix##Add, prefix##Sub, prefix##AddScalar, prefix##SubScalar, prefix##MulScalar, prefix##Dot, prefix##MulAdd, \
+      prefix##Axpy }
+#define TSIMD_TABLE_SCALAR_MUL(prefix, T) \
+    { prefix##Add, prefix##Sub, prefix##AddScalar, prefix##SubScalar, Scalar<T>::mulScalar, Scalar<T>::dot, \
+      Scalar<T>::mulAdd, Scalar<T>::axpy }
+
+    inline const TSimdKernels<float>* kernels(const float*, int lvl)
+    {
+        static const TSimdKernels<float> t[] = {
+            TSIMD_TABLE(sse2F, float), TSIMD_TABLE(avx2F, float), TSIMD_TABLE(avx512F, float) };
+        return lvl == SIMD_NONE ? nullptr : &t[lvl - 1];
+    }
+
+    inline const TSimdKernels<double>* kernels(const double*, int lvl)
+    {
+        static const TSimdKernels<double> t[] = {
+            TSIMD_TABLE(sse2D, double), TSIMD_TABLE(avx2D, double), TSIMD_TABLE(avx512D, double) };
+        return lvl == SIMD_NONE ? nullptr : &t[lvl - 1];
+    }
+
+    inline const TSimdKernels<int32_t>* kernels(const int32_t*, int lvl)
+    {
+        static const TSimdKernels<int32_t> t[] = {
+            TSIMD_TABLE_SCALAR_MUL(sse2I32, int32_t), TSIMD_TABLE(avx2I32, int32_t), TSIMD_TABLE(avx512I32, int32_t) };
+        return lvl == SIMD_NONE ? nullptr : &t[lvl - 1];
+    }
+
+    inline const TSimdKernels<int64_t>* kernels(const int64_t*, int lvl)
+    {
+        static const TSimdKernels<int64_t> t[] = {
+            TSIMD_TABLE_SCALAR_MUL(sse2I64, int64_t), TSIMD_TABLE_SCALAR_MUL(avx2I64, int64_t), TSIMD_TABLE(avx512I64, int64_t) };
+        return lvl == SIMD_NONE ? nullptr : &t[lvl - 1];
+    }
+
+#undef TSIMD_TABLE_SCALAR_MUL
+#undef TSIMD_TABLE
+
+    // срез SELL-8: 8 строк, элементы хранятся по столбцам среза (val[8k + r]),
+    // x читается сбором (gather) по 32-битным индексам
+    TSIMD_TARGET("avx2") inline void sell8Avx2F(const float* val, const uint32_t* col, size_t w, const float* x, float* y)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        for (size_t k = 0; k < w; k++) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(col + 8 * k));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(val + 8 * k), _mm256_i32gather_ps(x, idx, 4)));
+        }
+        _mm256_storeu_ps(y, acc);
+    }
+
+    TSIMD_TARGET("avx2") inline void sell8Avx2D(const double* val, const uint32_t* col, size_t w, const double* x, double* y)
+    {
+        // сбор с маской: вариант без маски дает ложное предупреждение GCC 12
+        const __m256d zero = _mm256_setzero_pd(), all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        __m256d acc0 = zero, acc1 = zero;
+        for (size_t k = 0; k < w; k++) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(col + 8 * k));
+            __m256d x0 = _mm256_mask_i32gather_pd(zero, x, _mm256_castsi256_si128(idx), all, 8);
+            __m256d x1 = _mm256_mask_i32gather_pd(zero, x, _mm256_extracti128_si256(idx, 1), all, 8);
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(val + 8 * k), x0));
+            acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(val + 8 * k + 4), x1));
+        }
+        _mm256_storeu_pd(y, acc0);
+        _mm256_storeu_pd(y + 4, acc1);
+    }
+
+    TSIMD_TARGET("avx512f") inline void sell8Avx512D(const double* val, const uint32_t* col, size_t w, const double* x, double* y)
+    {
+        const __m512d zero = _mm512_setzero_pd();
+        __m512d acc = zero;
+        for (size_t k = 0; k < w; k++) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(col + 8 * k));
+            __m512d xv = _mm512_mask_i32gather_pd(zero, 0xFF, idx, x, 8);
+            acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_loadu_pd(val + 8 * k), xv));
+        }
+        _mm512_storeu_pd(y, acc);
+    }
+
+    inline bool sell8(const float* val, const uint32_t* col, size_t w, const float* x, float* y, int lvl)
+    {
+        if (lvl < SIMD_AVX2)
+            return false;
+        sell8Avx2F(val, col, w, x, y);
+        return true;
+    }
+
+    inline bool sell8(const double* val, const uint32_t* col, size_t w, const double* x, double* y, int lvl)
+    {
+        if (lvl >= SIMD_AVX512)
+            sell8Avx512D(val, col, w, x, y);
+        else if (lvl == SIMD_AVX2)
+            sell8Avx2D(val, col, w, x, y);
+        else
+            return false;
+        return true;
+    }
+#endif
+
+    template<typename T, typename I>
+    void sell8Scalar(const T* val, const I* col, size_t w, const T* x, T* y)
+    {
+        T acc[8];
+        for (size_t r = 0; r < 8; r++)
+            acc[r] = T();
+        for (size_t k = 0; k < w; k++)
+            for (size_t r = 0; r < 8; r++)
+                acc[r] += val[8 * k + r] * x[col[8 * k + r]];
+        for (size_t r = 0; r < 8; r++)
+            y[r] = acc[r];
+    }
+
+    // для типов без векторного ядра среза
+    template<typename T>
+    bool sell8(const T*, const uint32_t*, size_t, const T*, T*, int)
+    {
+        return false;
+    }
+
+    // для типов без векторных ядер
+    template<typename T>
+    const TSimdKernels<T>* kernels(const T*, int)
+    {
+        return nullptr;
+    }
+
+    // ядра только для точного совпадения типа: доступ к данным через другой
+    // целый тип того же размера нарушал бы strict aliasing
+    template<typename T>
+    const TSimdKernels<T>* kernelsFor()
+    {
+        return kernels(static_cast<const T*>(nullptr), currentLevel().load(std::memory_order_relaxed));
+    }
+}
+
+// максимальный уровень, поддерживаемый процессором и ОС
+inline TSimdLevel supportedSimdLevel()
+{
+    return simd_detail::supportedLevel();
+}
+
+inline TSimdLevel simdLevel()
+{
+    return static_cast<TSimdLevel>(simd_detail::currentLevel().load());
+}
+
+// выбор уровня (не выше поддерживаемого); возвращает установленный уровень
+inline TSimdLevel setSimdLevel(TSimdLevel lvl)
+{
+    if (lvl > supportedSimdLevel())
+        lvl = supportedSimdLevel();
+    simd_detail::currentLevel() = lvl;
+    return lvl;
+}
+
+// r = a + b
+template<typename T>
+void simdAdd(const T* a, const T* b, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->add(a, b, r, n);
+    else
+        simd_detail::Scalar<T>::add(a, b, r, n);
+}
+
+// r = a - b
+template<typename T>
+void simdSub(const T* a, const T* b, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->sub(a, b, r, n);
+    else
+        simd_detail::Scalar<T>::sub(a, b, r, n);
+}
+
+// r = a + val
+template<typename T>
+void simdAddScalar(const T* a, const T& val, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->addScalar(a, val, r, n);
+    else
+        simd_detail::Scalar<T>::addScalar(a, val, r, n);
+}
+
+// r = a - val
+template<typename T>
+void simdSubScalar(const T* a, const T& val, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->subScalar(a, val, r, n);
+    else
+        simd_detail::Scalar<T>::subScalar(a, val, r, n);
+}
+
+// r = a * val
+template<typename T>
+void simdMulScalar(const T* a, const T& val, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->mulScalar(a, val, r, n);
+    else
+        simd_detail::Scalar<T>::mulScalar(a, val, r, n);
+}
+
+// скалярное произведение a и b
+template<typename T>
+T simdDot(const T* a, const T* b, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        return k->dot(a, b, n);
+    return simd_detail::Scalar<T>::dot(a, b, n);
+}
+
+// r += a * b (поэлементно)
+template<typename T>
+void simdMulAdd(const T* a, const T* b, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->mulAdd(a, b, r, n);
+    else
+        simd_detail::Scalar<T>::mulAdd(a, b, r, n);
+}
+
+// r = a + val * b; r может совпадать с a или b
+template<typename T>
+void simdAxpy(const T* a, const T& val, const T* b, T* r, size_t n)
+{
+    if (const TSimdKernels<T>* k = simd_detail::kernelsFor<T>())
+        k->axpy(a, val, b, r, n);
+    else
+        simd_detail::Scalar<T>::axpy(a, val, b, r, n);
+}
+
+// один срез SELL-8: y[r] = сумма по k < width val[8k + r] * x[col[8k + r]],
+// r = 0..7; индексы col должны быть меньше 2^31
+template<typename T>
+void simdSell8(const T* val, const uint32_t* col, size_t width, const T* x, T* y)
+{
+    if (!simd_detail::sell8(val, col, width, x, y, simd_detail::currentLevel().load(std::memory_order_relaxed)))
+        simd_detail::sell8Scalar(val, col, width, x, y);
+}
+
+#endif
@@ -0,0 +1,510 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TSOLVER_H__
+#define __TSOLVER_H__
+
+#include <cmath>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "tmatrix.h"
+
+// Итерационные методы решения систем A x = b: CG (симметричные
+// положительно определенные A), BiCGSTAB и GMRES(m) с перезапуском.
+// A - любая квадратная матрица библиотеки с методом multiply(x, y)
+// (y = A x без выделения памяти): TDynamicMatrix, TUpperTriangularMatrix,
+// TBandMatrix, TCSRMatrix, TSellMatrix. Предобуславливатель - любой тип
+// с методом apply(r, z), вычисляющим z = M^-1 r. Рабочие векторы
+// выделяются при создании решателя и переиспользуются между solve().
+
+// параметры остановки
+struct TSolverOptions
+{
+    size_t maxIterations = 1000;
+    double tolerance = 1e-8;  // по относительной невязке |b - A x| / |b|
+    // размер подпространства GMRES; 0 - размер решателя (для solveGMRES - 30)
+    size_t restart = 0;
+    // вызывается после каждой итерации с номером итерации и относительной
+    // невязкой; если вернула false, решатель останавливается
+    std::function<bool(size_t, double)> callback;
+};
+
+struct TSolverResult
+{
+    size_t iterations = 0;
+    double residual = 0;      // относительная невязка на выходе
+    bool converged = false;
+};
+
+// M = I
+template<typename T>
+class TIdentityPreconditioner
+{
+public:
+    void apply(const TDynamicVector<T>& r, TDynamicVector<T>& z) const
+    {
+        std::copy(r.data(), r.data() + r.size(), z.data());
+    }
+};
+
+// M = diag(A)
+template<typename T>
+class TJacobiPreconditioner
+{
+    TDynamicVector<T> inv;
+
+public:
+    TJacobiPreconditioner(const TDynamicVector<T>& diag) : inv(diag.size(), TNoInit())
+    {
+        for (size_t i = 0; i < diag.size(); i++) {
+            if (diag[i] == T())
+                throw invalid_argument("err");
+            inv[i] = T(1) / diag[i];
+        }
+    }
+
+    // только для матриц, у которых есть matrixDiagonal(), иначе шаблон
+    // перехватывал бы копирование неконстантного предобуславливателя
+    template<typename M, typename = typename std::enable_if<std::is_same<
+        decltype(matrixDiagonal(std::declval<const M&>())), TDynamicVector<T>>::value>::type>
+    TJacobiPreconditioner(const M& a) : TJacobiPreconditioner(matrixDiagonal(a)) {}
+
+    void apply(const TDynamicVector<T>& r, TDynamicVector<T>& z) const
+    {
+        if (r.size() != inv.size() || z.size() != inv.size())
+            throw invalid_argument("err");
+        for (size_t i = 0; i < inv.size(); i++)
+            z[i] = inv[i] * r[i];
+    }
+};
+
+// главная диагональ матрицы
+template<typename T>
+TDynamicVector<T> matrixDiagonal(const TDynamicMatrix<T>& a)
+{
+    TDynamicVector<T> d(a.rows(), TNoInit());
+    for (size_t i = 0; i < a.rows(); i++)
+        d[i] = a[i][i];
+    return d;
+}
+
+template<typename T>
+TDynamicVector<T> matrixDiagonal(const TUpperTriangularMatrix<T>& a)
+{
+    TDynamicVector<T> d(a.size(), TNoInit());
+    for (size_t i = 0; i < a.size(); i++)
+        d[i] = a.at(i, i);
+    return d;
+}
+
+template<typename T>
+TDynamicVector<T> matrixDiagonal(const TBandMatrix<T>& a)
+{
+    TDynamicVector<T> d(a.size(), TNoInit());
+    for (size_t i = 0; i < a.size(); i++)
+        d[i] = a.at(i, i);
+    return d;
+}
+
+template<typename T, typename I>
+TDynamicVector<T> matrixDiagonal(const TCSRMatrix<T, I>& a)
+{
+    TDynamicVector<T> d(a.size(), TNoInit());
+    for (size_t i = 0; i < a.size(); i++)
+        d[i] = a.at(i, i);
+    return d;
+}
+
+// слитые векторные операции на ядрах tsimd.h: векторы обрабатываются блоками
+// по SOLVER_BLOCK элементов, и все шаги операции выполняются над блоком, пока
+// он в кэше L1, - один проход по памяти вместо нескольких
+namespace solver_detail
+{
+    const size_t SOLVER_BLOCK = 512;
+
+    template<typename T>
+    T dot(const TDynamicVector<T>& a, const TDynamicVector<T>& b)
+    {
+        return simdDot(a.data(), b.data(), a.size());
+    }
+
+    template<typename T>
+    double norm(const TDynamicVector<T>& a)
+    {
+        return std::sqrt(static_cast<double>(dot(a, a)));
+    }
+
+    // r = b - r
+    template<typename T>
+    void residual(const TDynamicVector<T>& b, TDynamicVector<T>& r)
+    {
+        simdSub(b.data(), r.data(), r.data(), b.size());
+    }
+
+    // x += alpha * p, r -= alpha * q; возвращает (r, r)
+    template<typename T>
+    T updateXR(TDynamicVector<T>& x, TDynamicVector<T>& r, const TDynamicVector<T>& p,
+        const TDynamicVector<T>& q, T alpha)
+    {
+        T rr = T();
+        for (size_t i = 0; i < x.size(); i += SOLVER_BLOCK) {
+            size_t m = std::min(SOLVER_BLOCK, x.size() - i);
+            simdAxpy(x.data() + i, alpha, p.data() + i, x.data() + i, m);
+            simdAxpy(r.data() + i, T(-alpha), q.data() + i, r.data() + i, m);
+            rr += simdDot(r.data() + i, r.data() + i, m);
+        }
+        return rr;
+    }
+
+    // p = z + beta * p
+    template<typename T>
+    void xpby(const TDynamicVector<T>& z, T beta, TDynamicVector<T>& p)
+    {
+        simdAxpy(z.data(), beta, p.data(), p.data(), p.size());
+    }
+
+    // p = r + beta * (p - omega * v)
+    template<typename T>
+    void bicgDirection(const TDynamicVector<T>& r, T beta, T omega, const TDynamicVector<T>& v,
+        TDynamicVector<T>& p)
+    {
+        for (size_t i = 0; i < p.size(); i += SOLVER_BLOCK) {
+            size_t m = std::min(SOLVER_BLOCK, p.size() - i);
+            simdAxpy(p.data() + i, T(-omega), v.data() + i, p.data() + i, m);
+            simdAxpy(r.data() + i, beta, p.data() + i, p.data() + i, m);
+        }
+    }
+
+    // s = r - alpha * v; возвращает (s, s)
+    template<typename T>
+    T axpyNorm(const TDynamicVector<T>& r, T alpha, const TDynamicVector<T>& v, TDynamicVector<T>& s)
+    {
+        T ss = T();
+        for (size_t i = 0; i < s.size(); i += SOLVER_BLOCK) {
+            size_t m = std::min(SOLVER_BLOCK, s.size() - i);
+            simdAxpy(r.data() + i, T(-alpha), v.data() + i, s.data() + i, m);
+            ss += simdDot(s.data() + i, s.data() + i, m);
+        }
+        return ss;
+    }
+
+    // x += alpha * ph + omega * sh, r = s - omega * t; возвращает (r, r)
+    template<typename T>
+    T bicgUpdate(TDynamicVector<T>& x, TDynamicVector<T>& r, T alpha, const TDynamicVector<T>& ph,
+        T omega, const TDynamicVector<T>& sh, const TDynamicVector<T>& s, const TDynamicVector<T>& t)
+    {
+        T rr = T();
+        for (size_t i = 0; i < x.size(); i += SOLVER_BLOCK) {
+            size_t m = std::min(SOLVER_BLOCK, x.size() - i);
+            simdAxpy(x.data() + i, alpha, ph.data() + i, x.data() + i, m);
+            simdAxpy(x.data() + i, omega, sh.data() + i, x.data() + i, m);
+            simdAxpy(s.data() + i, T(-omega), t.data() + i, r.data() + i, m);
+            rr += simdDot(r.data() + i, r.data() + i, m);
+        }
+        return rr;
+    }
+
+    // y += alpha * x
+    template<typename T>
+    void axpy(T alpha, const TDynamicVector<T>& x, TDynamicVector<T>& y)
+    {
+        simdAxpy(y.data(), alpha, x.data(), y.data(), y.size());
+    }
+
+    inline bool report(const TSolverOptions& opt, TSolverResult& res, double rel)
+    {
+        res.iterations++;
+        res.residual = rel;
+        res.converged = rel <= opt.tolerance;
+        return !res.converged && (!opt.callback || opt.callback(res.iterations, rel))
+            && res.iterations < opt.maxIterations;
+    }
+
+    template<typename A, typename T>
+    void checkSizes(const A& a, const TDynamicVector<T>& b, const TDynamicVector<T>& x, size_t n)
+    {
+        if (a.size() != n || b.size() != n || x.size() != n)
+            throw invalid_argument("err");
+    }
+}
+
+// Метод сопряженных градиентов с предобуславливанием
+template<typename T>
+class TCGSolver
+{
+    size_t n;
+    TDynamicVector<T> r, z, p, q;
+
+public:
+    TCGSolver(size_t size) : n(size), r(size, TNoInit()), z(size, TNoInit()), p(size, TNoInit()), q(size, TNoInit()) {}
+
+    size_t size() const noexcept { return n; }
+
+    // x - начальное приближение и результат
+    template<typename A, typename P>
+    TSolverResult solve(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x, const P& m,
+        const TSolverOptions& opt = TSolverOptions())
+    {
+        using namespace solver_detail;
+        checkSizes(a, b, x, n);
+        TSolverResult res;
+        double bn = norm(b);
+        if (bn == 0) {
+            std::fill(x.data(), x.data() + n, T());
+            res.converged = true;
+            return res;
+        }
+
+        a.multiply(x, r);
+        residual(b, r);
+        res.residual = norm(r) / bn;
+        if ((res.converged = res.residual <= opt.tolerance) || opt.maxIterations == 0)
+            return res;
+        m.apply(r, z);
+        std::copy(z.data(), z.data() + n, p.data());
+        T rz = dot(r, z);
+        for (;;) {
+            a.multiply(p, q);
+            T pq = dot(p, q);
+            if (pq == T())
+                break;
+            T alpha = rz / pq;
+            T rr = updateXR(x, r, p, q, alpha);
+            if (!report(opt, res, std::sqrt(static_cast<double>(rr)) / bn))
+                break;
+            m.apply(r, z);
+            T rzNew = dot(r, z);
+            xpby(z, rzNew / rz, p);
+            rz = rzNew;
+        }
+        return res;
+    }
+
+    template<typename A>
+    TSolverResult solve(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x,
+        const TSolverOptions& opt = TSolverOptions())
+    {
+        return solve(a, b, x, TIdentityPreconditioner<T>(), opt);
+    }
+};
+
+// Стабилизированный метод бисопряженных градиентов (правое предобуславливание)
+template<typename T>
+class TBiCGStabSolver
+{
+    size_t n;
+    TDynamicVector<T> r, r0, p, v, s, t, ph, sh;
+
+public:
+    TBiCGStabSolver(size_t size) : n(size), r(size, TNoInit()), r0(size, TNoInit()), p(size), v(size),
+        s(size, TNoInit()), t(size, TNoInit()), ph(size, TNoInit()), sh(size, TNoInit()) {}
+
+    size_t size() const noexcept { return n; }
+
+    template<typename A, typename P>
+    TSolverResult solve(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x, const P& m,
+        const TSolverOptions& opt = TSolverOptions())
+    {
+        using namespace solver_detail;
+        checkSizes(a, b, x, n);
+        TSolverResult res;
+        double bn = norm(b);
+        if (bn == 0) {
+            std::fill(x.data(), x.data() + n, T());
+            res.converged = true;
+            return res;
+        }
+
+        a.multiply(x, r);
+        residual(b, r);
+        res.residual = norm(r) / bn;
+        if ((res.converged = res.residual <= opt.tolerance) || opt.maxIterations == 0)
+            return res;
+        std::copy(r.data(), r.data() + n, r0.data());
+        std::fill(p.data(), p.data() + n, T());
+        std::fill(v.data(), v.data() + n, T());
+        T rho = T(1), alpha = T(1), omega = T(1);
+        for (;;) {
+            T rhoNew = dot(r0, r);
+            if (rhoNew == T())
+                break;
+            bicgDirection(r, (rhoNew / rho) * (alpha / omega), omega, v, p);
+            m.apply(p, ph);
+            a.multiply(ph, v);
+            T r0v = dot(r0, v);
+            if (r0v == T())
+                break;
+            alpha = rhoNew / r0v;
+            T ss = axpyNorm(r, alpha, v, s);
+            if (std::sqrt(static_cast<double>(ss)) / bn <= opt.tolerance) {
+                axpy(alpha, ph, x);
+                report(opt, res, std::sqrt(static_cast<double>(ss)) / bn);
+                break;
+            }
+            m.apply(s, sh);
+            a.multiply(sh, t);
+            T tt = dot(t, t);
+            if (tt == T())
+                break;
+            omega = dot(t, s) / tt;
+            T rr = bicgUpdate(x, r, alpha, ph, omega, sh, s, t);
+            if (!report(opt, res, std::sqrt(static_cast<double>(rr)) / bn) || omega == T())
+                break;
+            rho = rhoNew;
+        }
+        return res;
+    }
+
+    template<typename A>
+    TSolverResult solve(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x,
+        const TSolverOptions& opt = TSolverOptions())
+    {
+        return solve(a, b, x, TIdentityPreconditioner<T>(), opt);
+    }
+};
+
+// GMRES(m) с перезапуском, правое предобуславливание, вращения Гивенса
+template<typename T>
+class TGMRESSolver
+{
+    size_t n, m;
+    TDynamicVector<TDynamicVector<T>> basis; // m + 1 векторов Крылова
+    TDynamicMatrix<T> h;                     // матрица Хессенберга, (m + 1) x m
+    TDynamicVector<T> cs, sn, g, y, w, z;
+
+public:
+    TGMRESSolver(size_t size, size_t restart = 30) : n(size), m(restart), basis(restart + 1),
+        h(restart + 1, restart), cs(restart), sn(restart), g(restart + 1), y(restart),
+        w(size, TNoInit()), z(size, TNoInit())
+    {
+        if (m == 0)
+            throw out_of_range("err");
+        for (size_t i = 0; i <= m; i++)
+            basis[i] = TDynamicVector<T>(n, TNoInit());
+    }
+
+    size_t size() const noexcept { return n; }
+    size_t restart() const noexcept { return m; }
+
+    // размер подпространства задается при создании решателя; ненулевой
+    // opt.restart должен с ним совпадать
+    template<typename A, typename P>
+    TSolverResult solve(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x, const P& pre,
+        const TSolverOptions& opt = TSolverOptions())
+    {
+        using namespace solver_detail;
+        checkSizes(a, b, x, n);
+        if (opt.restart != 0 && opt.restart != m)
+            throw invalid_argument("TSolverOptions::restart differs from the GMRES solver restart");
+        TSolverResult res;
+        double bn = norm(b);
+        if (bn == 0) {
+            std::fill(x.data(), x.data() + n, T());
+            res.converged = true;
+            return res;
+        }
+
+        TDynamicVector<T>& r = basis[0];
+        a.multiply(x, r);
+        residual(b, r);
+        double beta = norm(r);
+        res.residual = beta / bn;
+        if ((res.converged = res.residual <= opt.tolerance) || opt.maxIterations == 0)
+            return res;
+
+        bool more = true;
+        while (more) {
+            simdMulScalar(r.data(), T(1 / beta), r.data(), n);
+            std::fill(g.data(), g.data() + m + 1, T());
+            g[0] = T(beta);
+
+            size_t k = 0;
+            while (k < m && more) {
+                pre.apply(basis[k], z);
+                a.multiply(z, w);
+                // модифицированный Грам-Шмидт
+                for (size_t i = 0; i <= k; i++) {
+                    T hik = dot(w, basis[i]);
+                    h[i][k] = hik;
+                    axpy(-hik, basis[i], w);
+                }
+                T hk1 = T(norm(w));
+                h[k + 1][k] = hk1;
+                if (hk1 != T())
+                    simdMulScalar(w.data(), T(1) / hk1, basis[k + 1].data(), n);
+
+                for (size_t i = 0; i < k; i++) {
+                    T t0 = cs[i] * h[i][k] + sn[i] * h[i + 1][k];
+                    h[i + 1][k] = -sn[i] * h[i][k] + cs[i] * h[i + 1][k];
+                    h[i][k] = t0;
+                }
+                T d = T(std::sqrt(static_cast<double>(h[k][k] * h[k][k] + hk1 * hk1)));
+                cs[k] = d == T() ? T(1) : h[k][k] / d;
+                sn[k] = d == T() ? T() : hk1 / d;
+                h[k][k] = d;
+                h[k + 1][k] = T();
+                g[k + 1] = -sn[k] * g[k];
+                g[k] = cs[k] * g[k];
+                k++;
+
+                more = report(opt, res, std::abs(static_cast<double>(g[k])) / bn) && hk1 != T();
+            }
+
+            // y = H^-1 g, x += M^-1 (V y)
+            for (size_t i = k; i-- > 0;) {
+                T sum = g[i];
+                for (size_t j = i + 1; j < k; j++)
+                    sum -= h[i][j] * y[j];
+                y[i] = sum / h[i][i];
+            }
+            std::fill(w.data(), w.data() + n, T());
+            for (size_t i = 0; i < k; i++)
+                axpy(y[i], basis[i], w);
+            pre.apply(w, z);
+            simdAdd(x.data(), z.data(), x.data(), n);
+
+            if (more || !res.converged) {
+                // истинная невязка для перезапуска и окончательной оценки
+                a.multiply(x, r);
+                residual(b, r);
+                beta = norm(r);
+                res.residual = beta / bn;
+                res.converged = res.residual <= opt.tolerance;
+                more = more && !res.converged && beta != 0;
+            }
+        }
+        return res;
+    }
+
+    template<typename A>
+    TSolverResult solve(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x,
+        const TSolverOptions& opt = TSolverOptions())
+    {
+        return solve(a, b, x, TIdentityPreconditioner<T>(), opt);
+    }
+};
+
+// решение одним вызовом (рабочие векторы выделяются на каждый вызов)
+template<typename A, typename T, typename P = TIdentityPreconditioner<T>>
+TSolverResult solveCG(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x, const P& m = P(),
+    const TSolverOptions& opt = TSolverOptions())
+{
+    return TCGSolver<T>(b.size()).solve(a, b, x, m, opt);
+}
+
+template<typename A, typename T, typename P = TIdentityPreconditioner<T>>
+TSolverResult solveBiCGStab(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x, const P& m = P(),
+    const TSolverOptions& opt = TSolverOptions())
+{
+    return TBiCGStabSolver<T>(b.size()).solve(a, b, x, m, opt);
+}
+
+template<typename A, typename T, typename P = TIdentityPreconditioner<T>>
+TSolverResult solveGMRES(const A& a, const TDynamicVector<T>& b, TDynamicVector<T>& x, const P& m = P(),
+    const TSolverOptions& opt = TSolverOptions())
+{
+    return TGMRESSolver<T>(b.size(), opt.restart ? opt.restart : 30).solve(a, b, x, m, opt);
+}
+
+#endif
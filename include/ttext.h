@@ -0,0 +1,430 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TTEXT_H__
+#define __TTEXT_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "tthreadpool.h"
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <charconv>
+#endif
+
+// std::to_chars/std::from_chars для целых и плавающих типов (C++17)
+#ifdef __cpp_lib_to_chars
+#define TTEXT_CHARCONV 1
+#else
+#define TTEXT_CHARCONV 0
+#endif
+
+// Текстовый ввод/вывод элементов векторов и матриц для operator>> и operator<<.
+// Для чисел при обычном состоянии потока (десятичная система, классическая
+// локаль, без ширины поля и флагов showpos/showpoint/uppercase) числа
+// форматируются std::to_chars и разбираются std::from_chars большими блоками,
+// минуя посимвольное форматирование iostream. Результат совпадает с обычными
+// операторами: при выводе учитываются precision() и fixed/scientific, при
+// вводе лексемы выделяются по правилам num_get, так что значения, состояние
+// потока и место остановки при ошибке те же, что и при чтении по одному
+// элементу (inf и nan, как и у num_get, не принимаются). Иначе, а также для
+// нечисловых типов и без <charconv> (до C++17), используются операторы элементов.
+namespace text_detail
+{
+    const size_t TEXT_BLOCK = 1 << 14;          // элементов в одном блоке
+    const size_t TEXT_PARALLEL = 1 << 16;       // меньше - без распараллеливания
+    const size_t TEXT_BUFFER = size_t(1) << 20; // сброс буфера вывода
+
+    template<typename T>
+    struct isCharType : std::integral_constant<bool,
+        std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+        std::is_same<T, unsigned char>::value || std::is_same<T, wchar_t>::value ||
+        std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value> {};
+
+    // bool и символьные типы выводятся не как числа
+    template<typename T>
+    struct isNumber : std::integral_constant<bool, std::is_floating_point<T>::value ||
+        (std::is_integral<T>::value && !std::is_same<T, bool>::value && !isCharType<T>::value)> {};
+
+    template<typename T>
+    struct isFast : std::integral_constant<bool, TTEXT_CHARCONV && isNumber<T>::value> {};
+
+#if TTEXT_CHARCONV
+    inline bool classicStream(const std::ios_base& s)
+    {
+        const std::ios_base::fmtflags extra = std::ios_base::showpos | std::ios_base::showpoint |
+            std::ios_base::uppercase | std::ios_base::showbase;
+        return (s.flags() & extra) == 0 && (s.flags() & std::ios_base::basefield) == std::ios_base::dec &&
+            s.getloc() == std::locale::classic();
+    }
+
+    inline bool fastOutput(const std::ios_base& s)
+    {
+        return classicStream(s) && s.width() == 0 &&
+            (s.flags() & std::ios_base::floatfield) != (std::ios_base::fixed | std::ios_base::scientific);
+    }
+
+    inline bool fastInput(const std::ios_base& s)
+    {
+        return classicStream(s) && (s.flags() & std::ios_base::skipws);
+    }
+
+    template<typename T>
+    void format(std::string& out, T v, const std::ios_base& s, std::true_type /* плавающий */)
+    {
+        char tmp[128];
+        std::ios_base::fmtflags f = s.flags() & std::ios_base::floatfield;
+        std::chars_format cf = f == std::ios_base::fixed ? std::chars_format::fixed :
+            f == std::ios_base::scientific ? std::chars_format::scientific : std::chars_format::general;
+        int prec = static_cast<int>(s.precision());
+        std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), v, cf, prec);
+        if (r.ec == std::errc()) {
+            out.append(tmp, r.ptr);
+            return;
+        }
+        // fixed для очень больших чисел не помещается в буфер
+        std::ostringstream os;
+        os.flags(s.flags());
+        os.precision(s.precision());
+        os << v;
+        out += os.str();
+    }
+
+    template<typename T>
+    void format(std::string& out, T v, const std::ios_base&, std::false_type /* целый */)
+    {
+        char tmp[32];
+        std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        out.append(tmp, r.ptr);
+    }
+
+    // элементы [first, last) матрицы rows x cols с шагом строк ld; после каждого
+    // элемента пробел, после конца строки - перевод строки, если lines
+    template<typename T>
+    void formatRange(std::string& out, const T* data, size_t cols, size_t ld, bool lines,
+        size_t first, size_t last, const std::ios_base& s)
+    {
+        for (size_t k = first; k < last; ) {
+            size_t i = k / cols, j = k % cols;
+            size_t end = std::min(last, (i + 1) * cols);
+            const T* a = data + i * ld;
+            for (; j < cols && k < end; j++, k++) {
+                format(out, a[j], s, std::is_floating_point<T>());
+                out += ' ';
+            }
+            if (lines && j == cols)
+                out += '\n';
+        }
+    }
+
+    template<typename T>
+    void writeNumbers(std::ostream& os, const T* data, size_t rows, size_t cols, size_t ld, bool lines)
+    {
+        std::ostream::sentry guard(os);
+        if (!guard)
+            return;
+        std::streambuf* sb = os.rdbuf();
+        size_t total = rows * cols;
+        bool ok = true;
+        auto flush = [&](const std::string& s) {
+            if (ok && !s.empty())
+                ok = sb->sputn(s.data(), static_cast<std::streamsize>(s.size())) ==
+                    static_cast<std::streamsize>(s.size());
+        };
+
+        TThreadPool& pool = TThreadPool::instance();
+        size_t threads = pool.threadCount();
+        if (total < TEXT_PARALLEL || threads == 1) {
+            std::string out;
+            out.reserve(TEXT_BUFFER + 1024);
+            for (size_t k = 0; k < total && ok; k += TEXT_BLOCK) {
+                formatRange(out, data, cols, ld, lines, k, std::min(total, k + TEXT_BLOCK), os);
+                if (out.size() >= TEXT_BUFFER) {
+                    flush(out);
+                    out.clear();
+                }
+            }
+            flush(out);
+        }
+        else {
+            // за проход каждый поток форматирует свой блок, блоки пишутся по порядку
+            size_t blocks = (total + TEXT_BLOCK - 1) / TEXT_BLOCK;
+            std::vector<std::string> parts(threads);
+            for (size_t b0 = 0; b0 < blocks && ok; b0 += threads) {
+                size_t n = std::min(threads, blocks - b0);
+                pool.parallelFor(n, [&](size_t t) {
+                    size_t first = (b0 + t) * TEXT_BLOCK;
+                    parts[t].clear();
+                    formatRange(parts[t], data, cols, ld, lines, first, std::min(total, first + TEXT_BLOCK), os);
+                });
+                for (size_t t = 0; t < n; t++)
+                    flush(parts[t]);
+            }
+        }
+        if (!ok)
+            os.setstate(std::ios_base::badbit);
+    }
+
+    inline bool isSpace(int c) noexcept
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline bool isDigit(int c) noexcept
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // Лексема выделяется так же, как ее накапливает num_get: для целых
+    // [+-]?[0-9]*, для плавающих [+-]?[0-9]*(.[0-9]*)?([eE][+-]?[0-9]*)?, где
+    // порядок допускается только после цифр мантиссы. Поток останавливается
+    // на первом символе вне лексемы. Возвращает true, если лексема - полное
+    // число, заведомо представимое в T; иначе ее нужно проверить сразу.
+    template<typename T>
+    bool scan(std::streambuf* sb, int& c, std::string& buf, std::false_type /* целый */)
+    {
+        auto take = [&] { buf += static_cast<char>(c); c = sb->snextc(); };
+        if (c == '+' || c == '-')
+            take();
+        size_t digits = 0, significant = 0;
+        for (; isDigit(c); take()) {
+            digits++;
+            if (significant || c != '0')
+                significant++;
+        }
+        return digits > 0 && significant <= static_cast<size_t>(std::numeric_limits<T>::digits10);
+    }
+
+    template<typename T>
+    bool scan(std::streambuf* sb, int& c, std::string& buf, std::true_type /* плавающий */)
+    {
+        auto take = [&] { buf += static_cast<char>(c); c = sb->snextc(); };
+        if (c == '+' || c == '-')
+            take();
+        // exp10 - десятичный порядок первой значащей цифры
+        bool mantissa = false, nonzero = false;
+        long exp10 = 0;
+        for (; isDigit(c); take()) {
+            mantissa = true;
+            if (nonzero)
+                exp10++;
+            else if (c != '0')
+                nonzero = true;
+        }
+        if (c == '.') {
+            take();
+            for (long pos = 1; isDigit(c); take(), pos++) {
+                mantissa = true;
+                if (!nonzero && c != '0') {
+                    nonzero = true;
+                    exp10 = -pos;
+                }
+            }
+        }
+        bool complete = mantissa;
+        if (mantissa && (c == 'e' || c == 'E')) {
+            take();
+            bool minus = c == '-';
+            if (c == '+' || c == '-')
+                take();
+            long e = 0;
+            complete = isDigit(c);
+            for (; isDigit(c); take())
+                if (e < 100000)
+                    e = e * 10 + (c - '0');
+            exp10 += minus ? -e : e;
+        }
+        return complete && (!nonzero || (exp10 >= std::numeric_limits<T>::min_exponent10 &&
+            exp10 < std::numeric_limits<T>::max_exponent10));
+    }
+
+    template<typename T>
+    bool parse(const char* p, const char* e, T& v)
+    {
+        if (p < e && *p == '+' && e - p > 1 && p[1] != '-' && p[1] != '+')
+            p++;
+        // как и strtoul, беззнаковые принимают знак минус
+        bool negate = std::is_unsigned<T>::value && p < e && *p == '-';
+        if (negate)
+            p++;
+        std::from_chars_result r = std::from_chars(p, e, v);
+        if (r.ec != std::errc() || r.ptr != e)
+            return false;
+        if (negate)
+            v = static_cast<T>(T(0) - v);
+        return true;
+    }
+
+    // разбор лексемы, выделенной scan; если from_chars не справился (неполное
+    // число, переполнение), значение и ошибку дает сам оператор элемента
+    template<typename T>
+    bool parseToken(const char* p, const char* e, T& v)
+    {
+        if (parse(p, e, v))
+            return true;
+        if (p == e) {
+            v = T();
+            return false;
+        }
+        std::istringstream is(std::string(p, e));
+        is.imbue(std::locale::classic());
+        is >> v;
+        return !is.fail();
+    }
+
+    // разбор блока лексем; возвращает число успешно разобранных подряд
+    template<typename T>
+    size_t parseRange(const std::string& buf, const std::vector<size_t>& ends, size_t first, size_t last,
+        T* const* dst)
+    {
+        for (size_t k = first; k < last; k++) {
+            size_t b = k ? ends[k - 1] : 0;
+            if (!parseToken(buf.data() + b, buf.data() + ends[k], *dst[k]))
+                return k - first;
+        }
+        return last - first;
+    }
+
+    // Поток читается ровно до того же места, что и операторами элементов:
+    // сомнительная лексема разбирается сразу, и на первой ошибке чтение
+    // останавливается, а последующие элементы не изменяются.
+    template<typename T>
+    void readNumbers(std::istream& is, T* data, size_t rows, size_t cols, size_t ld)
+    {
+        std::istream::sentry guard(is, true);
+        if (!guard)
+            return;
+        std::streambuf* sb = is.rdbuf();
+        size_t total = rows * cols;
+        TThreadPool& pool = TThreadPool::instance();
+        std::string buf;
+        std::vector<size_t> ends;
+        std::vector<T*> dst;
+        std::ios_base::iostate state = std::ios_base::goodbit;
+        int c = sb->sgetc();
+
+        for (size_t k0 = 0; k0 < total && state == std::ios_base::goodbit; k0 += TEXT_BLOCK * 4) {
+            // последовательно выделяем лексемы, затем разбираем их, возможно параллельно
+            size_t count = std::min(total - k0, TEXT_BLOCK * 4);
+            buf.clear();
+            ends.clear();
+            dst.clear();
+            for (size_t k = 0; k < count; k++) {
+                while (c != std::char_traits<char>::eof() && isSpace(c))
+                    c = sb->snextc();
+                if (c == std::char_traits<char>::eof()) {
+                    state = std::ios_base::eofbit | std::ios_base::failbit;
+                    break;
+                }
+                size_t idx = k0 + k, b = buf.size();
+                T* d = data + idx / cols * ld + idx % cols;
+                if (!scan<T>(sb, c, buf, std::is_floating_point<T>()) &&
+                    !parseToken(buf.data() + b, buf.data() + buf.size(), *d)) {
+                    state = std::ios_base::failbit;
+                    break;
+                }
+                ends.push_back(buf.size());
+                dst.push_back(d);
+            }
+            if (c == std::char_traits<char>::eof())
+                state |= std::ios_base::eofbit;
+
+            size_t n = ends.size(), parsed = 0;
+            size_t parts = std::min(pool.threadCount(), n / TEXT_BLOCK);
+            if (n < TEXT_PARALLEL / 4 || parts < 2)
+                parsed = parseRange(buf, ends, 0, n, dst.data());
+            else {
+                std::vector<size_t> done(parts);
+                pool.parallelFor(parts, [&](size_t t) {
+                    size_t first = n * t / parts, last = n * (t + 1) / parts;
+                    done[t] = parseRange(buf, ends, first, last, dst.data());
+                });
+                for (size_t t = 0; t < parts; t++) {
+                    parsed += done[t];
+                    if (done[t] != n * (t + 1) / parts - n * t / parts)
+                        break;
+                }
+            }
+            if (parsed != n)
+                state |= std::ios_base::failbit;
+        }
+        if (state != std::ios_base::goodbit)
+            is.setstate(state);
+    }
+
+#endif
+
+    template<typename T>
+    void write(std::ostream& os, const T* data, size_t rows, size_t cols, size_t ld, bool lines, std::false_type)
+    {
+        for (size_t i = 0; i < rows; i++) {
+            const T* a = data + i * ld;
+            for (size_t j = 0; j < cols; j++)
+                os << a[j] << ' ';
+            if (lines)
+                os << '\n';
+        }
+    }
+
+#if TTEXT_CHARCONV
+    template<typename T>
+    void write(std::ostream& os, const T* data, size_t rows, size_t cols, size_t ld, bool lines, std::true_type)
+    {
+        if (rows == 0 || cols == 0)
+            return;
+        if (fastOutput(os)) {
+            writeNumbers(os, data, rows, cols, ld, lines);
+            return;
+        }
+        write(os, data, rows, cols, ld, lines, std::false_type());
+    }
+#endif
+
+    template<typename T>
+    void read(std::istream& is, T* data, size_t rows, size_t cols, size_t ld, std::false_type)
+    {
+        for (size_t i = 0; i < rows; i++) {
+            T* a = data + i * ld;
+            for (size_t j = 0; j < cols; j++)
+                is >> a[j];
+        }
+    }
+
+#if TTEXT_CHARCONV
+    template<typename T>
+    void read(std::istream& is, T* data, size_t rows, size_t cols, size_t ld, std::true_type)
+    {
+        if (rows == 0 || cols == 0)
+            return;
+        if (fastInput(is)) {
+            readNumbers(is, data, rows, cols, ld);
+            return;
+        }
+        read(is, data, rows, cols, ld, std::false_type());
+    }
+#endif
+}
+
+// вывод rows строк по cols элементов (шаг строк ld); каждый элемент
+// завершается пробелом, строка - переводом строки, если lines
+template<typename T>
+void writeText(std::ostream& os, const T* data, size_t rows, size_t cols, size_t ld, bool lines)
+{
+    text_detail::write(os, data, rows, cols, ld, lines, text_detail::isFast<T>());
+}
+
+template<typename T>
+void readText(std::istream& is, T* data, size_t rows, size_t cols, size_t ld)
+{
+    text_detail::read(is, data, rows, cols, ld, text_detail::isFast<T>());
+}
+
+#endif
@@ -0,0 +1,187 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TTHREADPOOL_H__
+#define __TTHREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Пул потоков библиотеки - создается один раз и живет до конца программы.
+// Число потоков берется из переменной окружения TMATRIX_NUM_THREADS,
+// иначе равно числу аппаратных потоков; меняется через setThreadCount().
+class TThreadPool
+{
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nThreads{1};  // workers.size() + 1, читается без блокировки
+    std::mutex mtx;
+    std::condition_variable wakeCv, doneCv;
+    std::mutex submitMtx;             // одновременно выполняется одно задание
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> next{0};
+    size_t generation = 0;
+    size_t active = 0;                // рабочие, еще не закончившие задание
+    std::exception_ptr error;         // первое исключение, брошенное заданием
+    bool stopping = false;
+
+    static bool& insideJob()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    static size_t defaultThreadCount()
+    {
+        if (const char* env = std::getenv("TMATRIX_NUM_THREADS")) {
+            long n = std::strtol(env, nullptr, 10);
+            if (n > 0)
+                return static_cast<size_t>(n);
+        }
+        size_t n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    void runItems()
+    {
+        try {
+            for (size_t i = next++; i < jobCount; i = next++)
+                (*job)(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!error)
+                error = std::current_exception();
+            next = jobCount;
+        }
+    }
+
+    void workerLoop(size_t seen)
+    {
+        insideJob() = true;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                wakeCv.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            runItems();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (--active == 0)
+                    doneCv.notify_one();
+            }
+        }
+    }
+
+    void start(size_t threads)
+    {
+        // вызывающий поток тоже выполняет работу, поэтому рабочих на один меньше
+        for (size_t i = 1; i < threads; i++)
+            workers.emplace_back(&TThreadPool::workerLoop, this, generation);
+        nThreads = threads;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wakeCv.notify_all();
+        for (auto& w : workers)
+            w.join();
+        workers.clear();
+        stopping = false;
+    }
+
+    TThreadPool() { start(defaultThreadCount()); }
+
+public:
+    TThreadPool(const TThreadPool&) = delete;
+    TThreadPool& operator=(const TThreadPool&) = delete;
+
+    ~TThreadPool() { stop(); }
+
+    static TThreadPool& instance()
+    {
+        static TThreadPool pool;
+        return pool;
+    }
+
+    // можно вызывать из любого потока, в том числе одновременно с setThreadCount()
+    size_t threadCount() const noexcept { return nThreads; }
+
+    // ждет завершения текущего задания; из задания parallelFor вызывать нельзя
+    void setThreadCount(size_t threads)
+    {
+        if (threads == 0)
+            throw std::out_of_range("Thread count should be greater than zero");
+        if (insideJob())
+            throw std::logic_error("setThreadCount cannot be called from a parallelFor job");
+        std::lock_guard<std::mutex> lock(submitMtx);
+        stop();
+        start(threads);
+    }
+
+    // выполняет f(0), ..., f(count - 1) на всех потоках пула и ждет завершения;
+    // вложенные вызовы из задания выполняются последовательно
+    void parallelFor(size_t count, const std::function<void(size_t)>& f)
+    {
+        if (count == 0)
+            return;
+        std::unique_lock<std::mutex> submit(submitMtx, std::defer_lock);
+        if (count > 1 && !insideJob())
+            submit.lock();
+        if (!submit.owns_lock() || workers.empty()) {
+            // задание и при последовательном выполнении остается заданием
+            bool outer = insideJob();
+            insideJob() = true;
+            try {
+                for (size_t i = 0; i < count; i++)
+                    f(i);
+            }
+            catch (...) {
+                insideJob() = outer;
+                throw;
+            }
+            insideJob() = outer;
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = &f;
+            jobCount = count;
+            next = 0;
+            active = workers.size();
+            generation++;
+        }
+        wakeCv.notify_all();
+
+        insideJob() = true;
+        runItems();
+        insideJob() = false;
+
+        std::unique_lock<std::mutex> lock(mtx);
+        doneCv.wait(lock, [&] { return active == 0; });
+        job = nullptr;
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,567 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+#ifndef __TTILED_H__
+#define __TTILED_H__
+
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "tmatrix.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Плиточная матрица вне оперативной памяти (out-of-core). Элементы хранятся
+// во временном файле квадратными плитками tileSize x tileSize, плитка за
+// плиткой построчно; краевые плитки дополнены нулями. Каждая матрица держит
+// в памяти не более cacheTiles плиток (LRU кэш с отложенной записью измененных
+// плиток), поэтому размер матрицы не ограничен MAX_MATRIX_SIZE, а расход
+// памяти - cacheTiles * tileSize^2 * sizeof(T) байт на матрицу. Умножение,
+// сложение и умножение на вектор обходят плитки по порядку и заранее
+// подгружают следующие в фоновом потоке, так что чтение с диска идет
+// одновременно со счетом.
+
+struct TTiledOptions
+{
+    size_t tileSize = 1024;
+    size_t cacheTiles = 16;     // не меньше 5: плитки C, A, B и две подгружаемые
+    string directory;           // каталог временного файла; пусто - TMPDIR или системный
+};
+
+// Временный файл с позиционным чтением/записью из нескольких потоков;
+// удаляется при закрытии
+class TTileFile
+{
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+
+public:
+    TTileFile(const string& directory, uint64_t size)
+    {
+#if defined(_WIN32)
+        char dir[MAX_PATH + 1], name[MAX_PATH + 1];
+        if (directory.empty())
+            GetTempPathA(sizeof(dir), dir);
+        else
+            strncpy_s(dir, directory.c_str(), _TRUNCATE);
+        if (!GetTempFileNameA(dir, "tmx", 0, name))
+            throw runtime_error("Cannot create tile file in " + string(dir));
+        file = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        if (file == INVALID_HANDLE_VALUE || !SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            throw runtime_error("Cannot create tile file " + string(name));
+        }
+#else
+        string dir = directory;
+        if (dir.empty()) {
+            const char* env = std::getenv("TMPDIR");
+            dir = env && *env ? env : "/tmp";
+        }
+        string name = dir + "/tmatrix-tiles-XXXXXX";
+        fd = mkstemp(&name[0]);
+        if (fd < 0)
+            throw runtime_error("Cannot create tile file in " + dir);
+        unlink(name.c_str());
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            throw runtime_error("Cannot allocate tile file of " + std::to_string(size) + " bytes");
+        }
+#endif
+    }
+
+    TTileFile(const TTileFile&) = delete;
+    TTileFile& operator=(const TTileFile&) = delete;
+
+    ~TTileFile()
+    {
+#if defined(_WIN32)
+        CloseHandle(file);
+#else
+        close(fd);
+#endif
+    }
+
+    void read(uint64_t offset, void* p, size_t bytes) const
+    {
+        char* dst = static_cast<char*>(p);
+        while (bytes > 0) {
+#if defined(_WIN32)
+            OVERLAPPED ov = {};
+            ov.Offset = static_cast<DWORD>(offset);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD part = static_cast<DWORD>(std::min<size_t>(bytes, 1u << 30)), done = 0;
+            if (!ReadFile(file, dst, part, &done, &ov) || done == 0)
+                throw runtime_error("Tile file read failed");
+#else
+            ssize_t done = pread(fd, dst, bytes, static_cast<off_t>(offset));
+            if (done <= 0)
+                throw runtime_error("Tile file read failed");
+#endif
+            dst += done;
+            offset += static_cast<uint64_t>(done);
+            bytes -= static_cast<size_t>(done);
+        }
+    }
+
+    void write(uint64_t offset, const void* p, size_t bytes)
+    {
+        const char* src = static_cast<const char*>(p);
+        while (bytes > 0) {
+#if defined(_WIN32)
+            OVERLAPPED ov = {};
+            ov.Offset = static_cast<DWORD>(offset);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD part = static_cast<DWORD>(std::min<size_t>(bytes, 1u << 30)), done = 0;
+            if (!WriteFile(file, src, part, &done, &ov) || done == 0)
+                throw runtime_error("Tile file write failed");
+#else
+            ssize_t done = pwrite(fd, src, bytes, static_cast<off_t>(offset));
+            if (done <= 0)
+                throw runtime_error("Tile file write failed");
+#endif
+            src += done;
+            offset += static_cast<uint64_t>(done);
+            bytes -= static_cast<size_t>(done);
+        }
+    }
+};
+
+// LRU кэш плиток. Плитка, выданная acquire(), закреплена до release() и не
+// вытесняется; если закреплены все плитки, кэш временно превышает емкость.
+// prefetch() ставит плитку в очередь фонового потока чтения, который
+// создается при первом вызове и один обслуживает весь кэш.
+template<typename T>
+class TTileCache
+{
+    enum State { LOADING, READY, FAILED };
+
+    struct Entry
+    {
+        size_t id;
+        TDynamicVector<T> data;
+        State state = LOADING;          // загружаемая плитка не вытесняется
+        std::exception_ptr error;       // причина FAILED
+        size_t pins = 0;
+        bool dirty = false;
+    };
+
+    TTileFile& file;
+    size_t elems, capacity;
+    std::list<Entry> lru; // в начале - недавно использованные
+    std::unordered_map<size_t, typename std::list<Entry>::iterator> index;
+    std::mutex mtx;
+    std::condition_variable loadedCv;   // запись вышла из LOADING
+    std::condition_variable queueCv;    // новая плитка в очереди или остановка
+    std::deque<size_t> queue;           // плитки для фонового чтения
+    std::thread reader;
+    bool stopping = false;
+
+    uint64_t offset(size_t id) const noexcept { return uint64_t(id) * elems * sizeof(T); }
+
+    void erase(size_t id)
+    {
+        auto found = index.find(id);
+        lru.erase(found->second);
+        index.erase(found);
+    }
+
+    // вытеснение при заполненном кэше, вызывается под mtx
+    void makeRoom()
+    {
+        auto it = lru.end();
+        while (lru.size() >= capacity && it != lru.begin()) {
+            --it;
+            if (it->pins != 0 || it->state != READY)
+                continue;
+            if (it->dirty)
+                file.write(offset(it->id), it->data.data(), elems * sizeof(T));
+            index.erase(it->id);
+            it = lru.erase(it);
+        }
+    }
+
+    // новая запись в состоянии LOADING под mtx; загружает ее вызывающий
+    Entry& insert(size_t id)
+    {
+        makeRoom();
+        TDynamicVector<T> data(elems, TNoInit());
+        lru.emplace_front();
+        Entry& e = lru.front();
+        e.id = id;
+        e.data = std::move(data);
+        index[id] = lru.begin();
+        return e;
+    }
+
+    // завершение загрузки под mtx; незакрепленная запись с ошибкой удаляется
+    void finish(Entry& e, std::exception_ptr err)
+    {
+        e.state = err ? FAILED : READY;
+        e.error = err;
+        if (err && e.pins == 0)
+            erase(e.id);
+        loadedCv.notify_all();
+    }
+
+    void readerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;) {
+            queueCv.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+            Entry& e = *index.find(queue.front())->second;
+            queue.pop_front();
+            lock.unlock();
+            std::exception_ptr err;
+            try {
+                file.read(offset(e.id), e.data.data(), elems * sizeof(T));
+            }
+            catch (...) {
+                err = std::current_exception();
+            }
+            lock.lock();
+            finish(e, err);
+        }
+    }
+
+public:
+    TTileCache(TTileFile& f, size_t tileElements, size_t cacheTiles)
+        : file(f), elems(tileElements), capacity(cacheTiles) {}
+
+    TTileCache(const TTileCache&) = delete;
+    TTileCache& operator=(const TTileCache&) = delete;
+
+    ~TTileCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        queueCv.notify_one();
+        if (reader.joinable())
+            reader.join();
+    }
+
+    size_t tileElements() const noexcept { return elems; }
+
+    void prefetch(size_t id)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (index.count(id))
+            return;
+        insert(id);
+        queue.push_back(id);
+        if (!reader.joinable())
+            reader = std::thread(&TTileCache::readerLoop, this);
+        queueCv.notify_one();
+    }
+
+    // закрепляет плитку; discard - содержимое будет полностью перезаписано,
+    // плитка не читается с диска и заполняется нулями
+    T* acquire(size_t id, bool write, bool discard = false)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        Entry* e;
+        auto found = index.find(id);
+        bool fresh = found == index.end();
+        if (fresh) {
+            // запись публикуется в состоянии LOADING, другие потоки ждут ее загрузки
+            e = &insert(id);
+            e->pins++;
+            lock.unlock();
+            std::exception_ptr err;
+            try {
+                if (discard)
+                    std::fill(e->data.data(), e->data.data() + elems, T());
+                else
+                    file.read(offset(id), e->data.data(), elems * sizeof(T));
+            }
+            catch (...) {
+                err = std::current_exception();
+            }
+            lock.lock();
+            finish(*e, err);
+        }
+        else {
+            lru.splice(lru.begin(), lru, found->second);
+            e = &*found->second;
+            e->pins++;
+            loadedCv.wait(lock, [&] { return e->state != LOADING; });
+        }
+        if (e->state == FAILED) {
+            std::exception_ptr err = e->error;
+            if (--e->pins == 0)
+                erase(id);
+            std::rethrow_exception(err);
+        }
+        e->dirty = e->dirty || write;
+        lock.unlock();
+        if (discard && !fresh)
+            std::fill(e->data.data(), e->data.data() + elems, T());
+        return e->data.data();
+    }
+
+    void release(size_t id)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto found = index.find(id);
+        if (found != index.end() && found->second->pins > 0)
+            found->second->pins--;
+    }
+
+    // запись всех измененных плиток на диск
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (Entry& e : lru) {
+            if (e.state == READY && e.dirty) {
+                file.write(offset(e.id), e.data.data(), elems * sizeof(T));
+                e.dirty = false;
+            }
+        }
+    }
+};
+
+template<typename T>
+class TTiledMatrix {
+private:
+    size_t nRows, nCols, tile, tRows, tCols;
+    TTiledOptions opts;
+    std::unique_ptr<TTileFile> file;           // файл переживает кэш
+    std::unique_ptr<TTileCache<T>> cache;
+
+    size_t tileId(size_t bi, size_t bj) const noexcept { return bi * tCols + bj; }
+
+    void checkTile(size_t bi, size_t bj) const {
+        if (bi >= tRows || bj >= tCols)
+            throw out_of_range("Tile index out of range");
+    }
+
+public:
+    // Закрепленная в кэше плитка; открепляется при уничтожении
+    class TTile {
+        TTileCache<T>* cache;
+        size_t id;
+        T* p;
+        size_t r, c, stride;
+
+    public:
+        TTile(TTileCache<T>* tc, size_t tileId, T* data, size_t rows, size_t cols, size_t ld) noexcept
+            : cache(tc), id(tileId), p(data), r(rows), c(cols), stride(ld) {}
+        TTile(TTile&& t) noexcept : cache(t.cache), id(t.id), p(t.p), r(t.r), c(t.c), stride(t.stride) { t.cache = nullptr; }
+        TTile(const TTile&) = delete;
+        TTile& operator=(const TTile&) = delete;
+        TTile& operator=(TTile&&) = delete;
+        ~TTile() { if (cache) cache->release(id); }
+
+        size_t rows() const noexcept { return r; }
+        size_t cols() const noexcept { return c; }
+        size_t ld() const noexcept { return stride; }
+        T* data() const noexcept { return p; }
+        // рабочая часть плитки (без дополнения краевых плиток)
+        TMatrixView<T> view() const noexcept { return TMatrixView<T>(p, r, c, stride); }
+    };
+
+    TTiledMatrix(size_t rows, size_t cols, const TTiledOptions& options = TTiledOptions())
+        : nRows(rows), nCols(cols), tile(options.tileSize), opts(options) {
+        if (nRows == 0 || nCols == 0)
+            throw out_of_range("Matrix size should be greater than zero");
+        if (tile == 0 || tile > MAX_MATRIX_SIZE)
+            throw out_of_range("Tile size out of range");
+        if (opts.cacheTiles < 5)
+            throw invalid_argument("Tile cache should hold at least 5 tiles");
+        tRows = (nRows + tile - 1) / tile;
+        tCols = (nCols + tile - 1) / tile;
+        uint64_t bytes = uint64_t(tRows) * tCols * tile * tile * sizeof(T);
+        file.reset(new TTileFile(opts.directory, bytes));
+        cache.reset(new TTileCache<T>(*file, tile * tile, opts.cacheTiles));
+    }
+
+    TTiledMatrix(const TDynamicMatrix<T>& m, const TTiledOptions& options = TTiledOptions())
+        : TTiledMatrix(m.rows(), m.cols(), options) {
+        for (size_t bi = 0; bi < tRows; bi++)
+            for (size_t bj = 0; bj < tCols; bj++) {
+                TTile t = writeTile(bi, bj, true);
+                for (size_t i = 0; i < t.rows(); i++)
+                    std::copy(m[bi * tile + i].data() + bj * tile, m[bi * tile + i].data() + bj * tile + t.cols(),
+                        t.data() + i * tile);
+            }
+    }
+
+    TTiledMatrix(TTiledMatrix&&) noexcept = default;
+
+    // старый кэш ссылается на свой файл и останавливает фоновое чтение,
+    // поэтому уничтожается раньше файла
+    TTiledMatrix& operator=(TTiledMatrix&& m) noexcept {
+        if (this != &m) {
+            cache.reset();
+            file = std::move(m.file);
+            cache = std::move(m.cache);
+            nRows = m.nRows;
+            nCols = m.nCols;
+            tile = m.tile;
+            tRows = m.tRows;
+            tCols = m.tCols;
+            opts = std::move(m.opts);
+        }
+        return *this;
+    }
+
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    size_t tileSize() const noexcept { return tile; }
+    size_t tileRows() const noexcept { return tRows; }
+    size_t tileCols() const noexcept { return tCols; }
+    const TTiledOptions& options() const noexcept { return opts; }
+
+    // доступ к плитке (bi, bj); запись помечает плитку измененной
+    TTile readTile(size_t bi, size_t bj) const {
+        checkTile(bi, bj);
+        size_t id = tileId(bi, bj);
+        T* p = cache->acquire(id, false);
+        return TTile(cache.get(), id, p, std::min(tile, nRows - bi * tile), std::min(tile, nCols - bj * tile), tile);
+    }
+
+    TTile writeTile(size_t bi, size_t bj, bool discard = false) {
+        checkTile(bi, bj);
+        size_t id = tileId(bi, bj);
+        T* p = cache->acquire(id, true, discard);
+        return TTile(cache.get(), id, p, std::min(tile, nRows - bi * tile), std::min(tile, nCols - bj * tile), tile);
+    }
+
+    // фоновая загрузка плитки, если ее нет в кэше
+    void prefetch(size_t bi, size_t bj) const {
+        if (bi < tRows && bj < tCols)
+            cache->prefetch(tileId(bi, bj));
+    }
+
+    void flush() { cache->flush(); }
+
+    T get(size_t i, size_t j) const {
+        if (i >= nRows || j >= nCols)
+            throw out_of_range("Index out of range");
+        TTile t = readTile(i / tile, j / tile);
+        return t.data()[(i % tile) * tile + j % tile];
+    }
+
+    void set(size_t i, size_t j, const T& value) {
+        if (i >= nRows || j >= nCols)
+            throw out_of_range("Index out of range");
+        TTile t = writeTile(i / tile, j / tile);
+        t.data()[(i % tile) * tile + j % tile] = value;
+    }
+
+    TDynamicMatrix<T> toDense() const {
+        TDynamicMatrix<T> res(nRows, nCols, TNoInit());
+        for (size_t bi = 0; bi < tRows; bi++)
+            for (size_t bj = 0; bj < tCols; bj++) {
+                prefetch(bi + (bj + 1) / tCols, (bj + 1) % tCols);
+                TTile t = readTile(bi, bj);
+                for (size_t i = 0; i < t.rows(); i++)
+                    std::copy(t.data() + i * tile, t.data() + i * tile + t.cols(),
+                        res[bi * tile + i].data() + bj * tile);
+            }
+        return res;
+    }
+
+    // res = this * b; плитки C считаются по очереди, пока идет умножение
+    // плиток A(i, k) * B(k, j), в фоне читаются A(i, k + 1) и B(k + 1, j)
+    void multiply(const TTiledMatrix& b, TTiledMatrix& res) const {
+        if (nCols != b.nRows || res.nRows != nRows || res.nCols != b.nCols)
+            throw invalid_argument("Matrix sizes do not match");
+        if (tile != b.tile || tile != res.tile)
+            throw invalid_argument("Tile sizes do not match");
+        if (&res == this || &res == &b)
+            throw invalid_argument("Result should not alias an operand");
+        for (size_t bi = 0; bi < tRows; bi++)
+            for (size_t bj = 0; bj < b.tCols; bj++) {
+                prefetch(bi, 0);
+                b.prefetch(0, bj);
+                TTile c = res.writeTile(bi, bj, true);
+                for (size_t bk = 0; bk < tCols; bk++) {
+                    prefetch(bi, bk + 1);
+                    b.prefetch(bk + 1, bj);
+                    TTile ta = readTile(bi, bk), tb = b.readTile(bk, bj);
+                    gemm(c.rows(), c.cols(), ta.cols(), ta.data(), tile, tb.data(), tile, c.data(), tile, bk == 0);
+                }
+            }
+    }
+
+    // res = this + b (res может совпадать с this или b)
+    void add(const TTiledMatrix& b, TTiledMatrix& res) const {
+        if (nRows != b.nRows || nCols != b.nCols || nRows != res.nRows || nCols != res.nCols)
+            throw invalid_argument("Matrix sizes do not match");
+        if (tile != b.tile || tile != res.tile)
+            throw invalid_argument("Tile sizes do not match");
+        for (size_t bi = 0; bi < tRows; bi++)
+            for (size_t bj = 0; bj < tCols; bj++) {
+                size_t ni = bi + (bj + 1) / tCols, nj = (bj + 1) % tCols;
+                prefetch(ni, nj);
+                b.prefetch(ni, nj);
+                bool inPlace = &res == this || &res == &b;
+                TTile ta = readTile(bi, bj), tb = b.readTile(bi, bj);
+                TTile c = res.writeTile(bi, bj, !inPlace);
+                simdAdd(ta.data(), tb.data(), c.data(), tile * tile);
+            }
+    }
+
+    void multiply(const TDynamicVector<T>& v, TDynamicVector<T>& res) const {
+        if (nCols != v.size() || nRows != res.size())
+            throw invalid_argument("Matrix and vector sizes do not match");
+        std::fill(res.data(), res.data() + nRows, T());
+        for (size_t bi = 0; bi < tRows; bi++)
+            for (size_t bj = 0; bj < tCols; bj++) {
+                prefetch(bi + (bj + 1) / tCols, (bj + 1) % tCols);
+                TTile t = readTile(bi, bj);
+                const T* x = v.data() + bj * tile;
+                T* y = res.data() + bi * tile;
+                for (size_t i = 0; i < t.rows(); i++)
+                    y[i] += simdDot(t.data() + i * tile, x, t.cols());
+            }
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
+        TDynamicVector<T> res(nRows, TNoInit());
+        multiply(v, res);
+        return res;
+    }
+
+    // результат - новая плиточная матрица с теми же параметрами
+    TTiledMatrix operator*(const TTiledMatrix& b) const {
+        TTiledMatrix res(nRows, b.nCols, opts);
+        multiply(b, res);
+        return res;
+    }
+
+    TTiledMatrix operator+(const TTiledMatrix& b) const {
+        TTiledMatrix res(nRows, nCols, opts);
+        add(b, res);
+        return res;
+    }
+};
+
+#endif
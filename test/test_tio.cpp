@@ -0,0 +1,608 @@
+#include "tio.h"
+#include <gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+    TDynamicMatrix<double> sample(size_t r, size_t c)
+    {
+        TDynamicMatrix<double> m(r, c);
+        for (size_t i = 0; i < r; i++)
+            for (size_t j = 0; j < c; j++)
+                m[i][j] = double(i * c + j) * 0.5 - 3;
+        return m;
+    }
+
+    TCSRMatrix<double> sparse(size_t n)
+    {
+        TCSRBuilder<double> b(n);
+        for (size_t i = 0; i < n; i++) {
+            b.add(i, i, 4 + double(i));
+            if (i + 3 < n)
+                b.add(i, i + 3, -1);
+        }
+        return b.build();
+    }
+
+    template<typename M>
+    M roundTrip(const M& m)
+    {
+        std::stringstream ss;
+        writeBinary(ss, m);
+        M res;
+        readBinary(ss, res);
+        return res;
+    }
+
+    // temporary file removed when the test ends
+    struct TTempFile
+    {
+        std::string path;
+        TTempFile(const std::string& name) : path(name) {}
+        ~TTempFile() { std::remove(path.c_str()); }
+    };
+}
+
+TEST(TIO, header_takes_64_bytes_and_payload_is_aligned)
+{
+    std::stringstream ss;
+    writeBinary(ss, TDynamicVector<double>(3));
+    std::string s = ss.str();
+    EXPECT_EQ(0, s.compare(0, 7, "TMATRIX"));
+    EXPECT_EQ(0u, s.size() % BINARY_ALIGNMENT);
+    EXPECT_EQ(128u, s.size());
+}
+
+TEST(TIO, vector_round_trip)
+{
+    TDynamicVector<int> v(7);
+    for (size_t i = 0; i < v.size(); i++)
+        v[i] = int(i * i) - 10;
+    EXPECT_EQ(v, roundTrip(v));
+}
+
+TEST(TIO, dense_round_trip_ignores_padding)
+{
+    TDynamicMatrix<double> m(5, 3, 8);
+    TDynamicMatrix<double> s = sample(5, 3);
+    for (size_t i = 0; i < 5; i++)
+        for (size_t j = 0; j < 3; j++)
+            m[i][j] = s[i][j];
+
+    std::stringstream ss;
+    writeBinary(ss, m);
+    EXPECT_EQ(64u + 64u * 2, ss.str().size()); // 15 doubles, one aligned section
+    TDynamicMatrix<double> res;
+    readBinary(ss, res);
+    EXPECT_EQ(s, res);
+}
+
+TEST(TIO, triangular_round_trip)
+{
+    TUpperTriangularMatrix<double> m(6);
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = i; j < 6; j++)
+            m.at(i, j) = double(i + 2 * j) + 1;
+    TUpperTriangularMatrix<double> res = roundTrip(m);
+    ASSERT_EQ(6u, res.size());
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = i; j < 6; j++)
+            EXPECT_EQ(m.at(i, j), res.at(i, j));
+}
+
+TEST(TIO, band_round_trip_keeps_bandwidths)
+{
+    TBandMatrix<double> m(9, 2, 1);
+    for (size_t i = 0; i < 9; i++)
+        for (size_t j = i > 2 ? i - 2 : 0; j <= i + 1 && j < 9; j++)
+            m.at(i, j) = double(i * 10 + j);
+    std::stringstream ss;
+    writeBinary(ss, m);
+    TBandMatrix<double> res(3, 0, 0);
+    readBinary(ss, res);
+    EXPECT_EQ(9u, res.size());
+    EXPECT_EQ(2u, res.lowerBandWidth());
+    EXPECT_EQ(1u, res.upperBandWidth());
+    for (size_t i = 0; i < 9; i++)
+        for (size_t j = i > 2 ? i - 2 : 0; j <= i + 1 && j < 9; j++)
+            EXPECT_EQ(m.at(i, j), res.at(i, j));
+}
+
+TEST(TIO, csr_round_trip)
+{
+    TCSRMatrix<double> m = sparse(20);
+    TCSRMatrix<double> res = roundTrip(m);
+    EXPECT_EQ(m.nonZeros(), res.nonZeros());
+    TDynamicVector<double> x(20);
+    for (size_t i = 0; i < 20; i++)
+        x[i] = double(i) - 7;
+    EXPECT_EQ(m * x, res * x);
+}
+
+// readers finish with m = std::move(res); a copy there doubles the peak memory
+static_assert(std::is_nothrow_move_assignable<TDynamicVector<double>>::value, "");
+static_assert(std::is_nothrow_move_assignable<TDynamicMatrix<double>>::value, "");
+static_assert(std::is_nothrow_move_assignable<TUpperTriangularMatrix<double>>::value, "");
+static_assert(std::is_nothrow_move_assignable<TBandMatrix<double>>::value, "");
+static_assert(std::is_nothrow_move_assignable<TCSRMatrix<double>>::value, "");
+
+TEST(TIO, loaded_matrix_is_moved_not_copied)
+{
+    TCSRMatrix<double> a = roundTrip(sparse(20)), b(1);
+    const double* p = a.view().values();
+    b = std::move(a);
+    EXPECT_EQ(p, b.view().values());
+
+    TDynamicMatrix<double> d = roundTrip(sample(4, 6)), e(1);
+    const double* q = d.data();
+    e = std::move(d);
+    EXPECT_EQ(q, e.data());
+}
+
+TEST(TIO, throws_on_type_mismatch)
+{
+    std::stringstream ss;
+    writeBinary(ss, sample(2, 2));
+    TDynamicMatrix<float> f;
+    ASSERT_ANY_THROW(readBinary(ss, f));
+
+    std::stringstream ss2;
+    writeBinary(ss2, sample(2, 2));
+    TDynamicVector<double> v;
+    ASSERT_ANY_THROW(readBinary(ss2, v));
+}
+
+TEST(TIO, throws_on_bad_or_truncated_data)
+{
+    std::stringstream bad("definitely not a matrix file, but long enough to hold a header......");
+    TDynamicVector<double> v;
+    ASSERT_ANY_THROW(readBinary(bad, v));
+
+    std::stringstream ss;
+    writeBinary(ss, sample(4, 4));
+    std::stringstream cut(ss.str().substr(0, 100));
+    TDynamicMatrix<double> m;
+    ASSERT_ANY_THROW(readBinary(cut, m));
+}
+
+TEST(TIO, mapped_file_gives_zero_copy_views)
+{
+    TTempFile dense("tio_dense.bin"), csr("tio_csr.bin");
+    TDynamicMatrix<double> m = sample(7, 5);
+    TCSRMatrix<double> a = sparse(30);
+    saveBinary(dense.path, m);
+    saveBinary(csr.path, a);
+
+    TMappedMatrix md(dense.path);
+    EXPECT_EQ(uint32_t(BIN_DENSE), md.header().format);
+    TMatrixView<const double> v = md.dense<double>();
+    ASSERT_EQ(7u, v.rows());
+    ASSERT_EQ(5u, v.cols());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v.data()) % BINARY_ALIGNMENT);
+    for (size_t i = 0; i < 7; i++)
+        for (size_t j = 0; j < 5; j++)
+            EXPECT_EQ(m[i][j], v[i][j]);
+    ASSERT_ANY_THROW(md.csr<double>());
+
+    TMappedMatrix mc(csr.path);
+    TCSRView<double> view = mc.csr<double>();
+    EXPECT_EQ(a.nonZeros(), view.nonZeros());
+    TDynamicVector<double> x(30);
+    for (size_t i = 0; i < 30; i++)
+        x[i] = double(i % 4) + 1;
+    EXPECT_EQ(a * x, view * x);
+
+    TDynamicMatrix<double> loaded;
+    loadBinary(dense.path, loaded);
+    EXPECT_EQ(m, loaded);
+}
+
+TEST(TIO, mapped_csr_rejects_corrupted_structure)
+{
+    TTempFile file("tio_bad_csr.bin");
+    const size_t n = 30;
+    saveBinary(file.path, sparse(n));
+    std::string data;
+    {
+        std::ifstream is(file.path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    size_t rowsOff = sizeof(TBinaryHeader), colsOff = binaryAlign(rowsOff + (n + 1) * sizeof(uint32_t));
+    auto patched = [&](size_t off, uint32_t value) {
+        std::string bad = data;
+        std::memcpy(&bad[off], &value, sizeof(value));
+        std::ofstream os(file.path, std::ios::binary);
+        os << bad;
+    };
+
+    patched(colsOff + 5 * sizeof(uint32_t), uint32_t(n));       // column out of range
+    {
+        TMappedMatrix m(file.path);
+        ASSERT_ANY_THROW(m.csr<double>());
+        ASSERT_NO_THROW(m.csrUnchecked<double>());
+    }
+    patched(rowsOff + 4 * sizeof(uint32_t), 1000);              // rows not monotonic
+    {
+        TMappedMatrix m(file.path);
+        ASSERT_ANY_THROW(m.csr<double>());
+    }
+    patched(rowsOff, 0);                                        // intact again
+    TMappedMatrix m(file.path);
+    EXPECT_EQ(sparse(n).nonZeros(), m.csr<double>().nonZeros());
+}
+
+TEST(TIO, mapping_throws_on_missing_file)
+{
+    ASSERT_ANY_THROW(TMappedMatrix("no/such/dir/matrix.bin"));
+}
+
+TEST(TIO, matrix_market_reads_general_real)
+{
+    std::stringstream ss(
+        "%%MatrixMarket matrix coordinate real general\n"
+        "% comment line\n"
+        "\n"
+        "3 3 4\n"
+        "1 1 2.5\n"
+        "3 1 -1e-1\r\n"
+        "2 3 +4\n"
+        "1 1 0.5\n");
+    TCSRMatrix<double> m;
+    readMatrixMarket(ss, m);
+    ASSERT_EQ(3u, m.size());
+    EXPECT_EQ(3u, m.nonZeros());
+    EXPECT_EQ(3.0, m.at(0, 0)); // duplicates are summed
+    EXPECT_EQ(-0.1, m.at(2, 0));
+    EXPECT_EQ(4.0, m.at(1, 2));
+}
+
+TEST(TIO, matrix_market_expands_symmetric_and_skew)
+{
+    std::stringstream sym(
+        "%%MatrixMarket matrix coordinate integer symmetric\n"
+        "3 3 3\n1 1 5\n2 1 -2\n3 2 7\n");
+    TCSRMatrix<int> a;
+    readMatrixMarket(sym, a);
+    EXPECT_EQ(5u, a.nonZeros());
+    EXPECT_EQ(-2, a.at(0, 1));
+    EXPECT_EQ(-2, a.at(1, 0));
+    EXPECT_EQ(7, a.at(1, 2));
+
+    std::stringstream skew(
+        "%%MatrixMarket MATRIX Coordinate Real Skew-Symmetric\n"
+        "2 2 1\n2 1 1.5\n");
+    TCSRMatrix<double> b;
+    readMatrixMarket(skew, b);
+    EXPECT_EQ(1.5, b.at(1, 0));
+    EXPECT_EQ(-1.5, b.at(0, 1));
+}
+
+TEST(TIO, matrix_market_pattern_gives_ones)
+{
+    std::stringstream ss(
+        "%%MatrixMarket matrix coordinate pattern general\n"
+        "4 4 2\n1 4\n4 2\n");
+    TCSRMatrix<float, uint16_t> m;
+    readMatrixMarket(ss, m);
+    EXPECT_EQ(2u, m.nonZeros());
+    EXPECT_EQ(1.0f, m.at(0, 3));
+    EXPECT_EQ(1.0f, m.at(3, 1));
+}
+
+TEST(TIO, matrix_market_rejects_bad_input)
+{
+    const char* bad[] = {
+        "%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n4\n",
+        "%%MatrixMarket matrix coordinate complex general\n1 1 1\n1 1 1 0\n",
+        "%%MatrixMarket matrix coordinate real general\n2 3 0\n",
+        "%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1\n",
+        "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1\n",
+        "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 1 x\n",
+        "not a matrix\n"
+    };
+    for (const char* text : bad) {
+        std::stringstream ss(text);
+        TCSRMatrix<double> m;
+        EXPECT_ANY_THROW(readMatrixMarket(ss, m)) << text;
+    }
+
+    std::stringstream real("%%MatrixMarket matrix coordinate real general\n1 1 1\n1 1 0.5\n");
+    TCSRMatrix<int> m;
+    EXPECT_ANY_THROW(readMatrixMarket(real, m));
+}
+
+TEST(TIO, matrix_market_huge_declared_count_does_not_preallocate)
+{
+    const char* huge[] = {
+        "%%MatrixMarket matrix coordinate real general\n2 2 18446744073709551615\n1 1 1\n",
+        "%%MatrixMarket matrix coordinate real symmetric\n2 2 9223372036854775808\n1 1 1\n",
+        "%%MatrixMarket matrix coordinate real general\n4294967296 4294967296 4294967296\n1 1 1\n"
+    };
+    for (const char* text : huge) {
+        std::stringstream ss(text);
+        TCSRMatrix<double, uint64_t> m;
+        EXPECT_THROW(readMatrixMarket(ss, m), std::runtime_error) << text;
+    }
+}
+
+TEST(TIO, matrix_market_round_trip_crosses_chunks)
+{
+    // large enough for the text to span several read chunks
+    const size_t n = 30000;
+    TCSRBuilder<double> b(n);
+    for (size_t i = 0; i < n; i++) {
+        b.add(i, i, 2 + 1.0 / double(i + 3));
+        if (i > 0)
+            b.add(i, i - 1, -1.0 / 3);
+        if (i + 7 < n)
+            b.add(i, i + 7, 0.1 * double(i % 11));
+    }
+    TCSRMatrix<double> m = b.build();
+
+    std::stringstream ss;
+    writeMatrixMarket(ss, m);
+    EXPECT_GT(ss.str().size(), 2 * MTX_CHUNK);
+    TCSRMatrix<double> res;
+    readMatrixMarket(ss, res);
+    EXPECT_EQ(m.nonZeros(), res.nonZeros());
+    TDynamicVector<double> x(n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = double(i % 13) - 6;
+    EXPECT_EQ(m * x, res * x);
+}
+
+namespace
+{
+    // .npy file as numpy would write it, with a hand-made header
+    std::string npyFile(const std::string& dict, const void* data, size_t bytes, int major = 1)
+    {
+        std::string h = dict;
+        size_t pre = major == 1 ? 10 : 12;
+        while ((pre + h.size() + 1) % 16 != 0)
+            h += ' ';
+        h += '\n';
+        std::string s("\x93NUMPY", 6);
+        s += char(major);
+        s += char(0);
+        s += char(h.size() & 0xff);
+        s += char(h.size() >> 8);
+        if (major != 1)
+            s += std::string(2, '\0');
+        return s + h + std::string(static_cast<const char*>(data), bytes);
+    }
+}
+
+TEST(TIO, npy_round_trip_of_vector_and_matrix)
+{
+    TDynamicVector<float> v(5);
+    for (size_t i = 0; i < 5; i++)
+        v[i] = float(i) * 1.5f - 2;
+    std::stringstream sv;
+    writeNpy(sv, v);
+    EXPECT_EQ(0, sv.str().compare(0, 6, "\x93NUMPY"));
+    EXPECT_NE(std::string::npos, sv.str().find("'shape': (5,)"));
+    TDynamicVector<float> v1;
+    readNpy(sv, v1);
+    EXPECT_EQ(v, v1);
+
+    TDynamicMatrix<double> m(4, 3, 8);
+    TDynamicMatrix<double> s = sample(4, 3);
+    for (size_t i = 0; i < 4; i++)
+        for (size_t j = 0; j < 3; j++)
+            m[i][j] = s[i][j];
+    std::stringstream sm;
+    writeNpy(sm, m);
+    EXPECT_EQ(128u + 12 * sizeof(double), sm.str().size()); // header padded to 64 bytes
+    TDynamicMatrix<double> m1;
+    readNpy(sm, m1);
+    EXPECT_EQ(s, m1);
+}
+
+TEST(TIO, npy_reads_fortran_order_and_foreign_byte_order)
+{
+    // column-major 2 x 3: [[1, 2, 3], [4, 5, 6]]
+    double f[] = { 1, 4, 2, 5, 3, 6 };
+    std::stringstream sf(npyFile("{'descr': '<f8', 'fortran_order': True, 'shape': (2, 3), }", f, sizeof(f)));
+    TDynamicMatrix<double> m;
+    readNpy(sf, m);
+    ASSERT_EQ(2u, m.rows());
+    ASSERT_EQ(3u, m.cols());
+    EXPECT_EQ(2.0, m[0][1]);
+    EXPECT_EQ(4.0, m[1][0]);
+    EXPECT_EQ(6.0, m[1][2]);
+
+    // big-endian int32 [1, 258, -2], version 2.0 header
+    const unsigned char be[] = { 0, 0, 0, 1, 0, 0, 1, 2, 0xff, 0xff, 0xff, 0xfe };
+    std::stringstream sb(npyFile("{\"descr\": \">i4\", \"fortran_order\": False, \"shape\": (3,)}", be, sizeof(be), 2));
+    TDynamicVector<int32_t> v;
+    readNpy(sb, v);
+    ASSERT_EQ(3u, v.size());
+    EXPECT_EQ(1, v[0]);
+    EXPECT_EQ(258, v[1]);
+    EXPECT_EQ(-2, v[2]);
+}
+
+TEST(TIO, npy_rejects_mismatched_arrays)
+{
+    std::stringstream s1;
+    writeNpy(s1, sample(2, 2));
+    TDynamicMatrix<float> f;
+    ASSERT_ANY_THROW(readNpy(s1, f));
+
+    std::stringstream s2;
+    writeNpy(s2, sample(2, 2));
+    TDynamicVector<double> v;
+    ASSERT_ANY_THROW(readNpy(s2, v));
+
+    double x[] = { 1, 2 };
+    std::stringstream s3(npyFile("{'descr': '<c16', 'fortran_order': False, 'shape': (1,), }", x, sizeof(x)));
+    ASSERT_ANY_THROW(readNpy(s3, v));
+
+    std::stringstream s4(npyFile("{'descr': '<f8', 'fortran_order': False, 'shape': (3,), }", x, sizeof(x)));
+    ASSERT_ANY_THROW(readNpy(s4, v));
+}
+
+TEST(TIO, mapped_npy_gives_aligned_zero_copy_views)
+{
+    TTempFile vec("tio_vec.npy"), mat("tio_mat.npy"), fort("tio_fort.npy");
+    TDynamicVector<int64_t> v(9);
+    for (size_t i = 0; i < 9; i++)
+        v[i] = int64_t(i) * 1000000007;
+    TDynamicMatrix<double> m = sample(6, 4);
+    saveNpy(vec.path, v);
+    saveNpy(mat.path, m);
+
+    TMappedNpy mv(vec.path);
+    TMatrixRow<const int64_t> rv = mv.vector<int64_t>();
+    ASSERT_EQ(9u, rv.size());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(rv.data()) % BINARY_ALIGNMENT);
+    for (size_t i = 0; i < 9; i++)
+        EXPECT_EQ(v[i], rv[i]);
+    ASSERT_ANY_THROW(mv.dense<int64_t>());
+    ASSERT_ANY_THROW(mv.vector<double>());
+
+    TMappedNpy mm(mat.path);
+    TMatrixView<const double> view = mm.dense<double>();
+    ASSERT_EQ(6u, view.rows());
+    ASSERT_EQ(4u, view.cols());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(view.data()) % BINARY_ALIGNMENT);
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = 0; j < 4; j++)
+            EXPECT_EQ(m[i][j], view[i][j]);
+
+    double f[] = { 1, 4, 2, 5, 3, 6 };
+    {
+        std::ofstream os(fort.path, std::ios::binary);
+        os << npyFile("{'descr': '<f8', 'fortran_order': True, 'shape': (2, 3), }", f, sizeof(f));
+    }
+    TMappedNpy mf(fort.path);
+    EXPECT_TRUE(mf.fortranOrder());
+    TMatrixView<const double> t = mf.dense<double>();
+    ASSERT_EQ(3u, t.rows());
+    ASSERT_EQ(2u, t.cols());
+    EXPECT_EQ(4.0, t[0][1]);
+    EXPECT_EQ(3.0, t[2][0]);
+}
+
+// written by Python's zipfile as np.savez does (force_zip64=True), with
+// zipfile.ZIP64_LIMIT and ZIP_FILECOUNT_LIMIT lowered so that the central
+// directory also uses Zip64 extras and the Zip64 end record:
+// a = int32 [1, -2, 3], b = float64 [[0.5, 1.5], [2.5, 3.5]]
+static const char pythonNpz[] =
+        "PK\003\004-\000\000\000\000\000\000\000!P\236\347y\020\377\377\377\377\377\377\377\377\005\000"
+        "\024\000a.npy\001\000\020\000\214\000\000\000\000\000\000\000\214\000\000\000\000\000\000\000"
+        "\223NUMPY\001\000v\000{'descr': '<i4', 'fortran_order': False, 'shape': (3,), }                 "
+        "                                           \012\001\000\000\000\376\377\377\377\003\000\000\000P"
+        "K\003\004-\000\000\000\000\000\000\000!P\351\362\366\355\377\377\377\377\377\377\377\377\005\000"
+        "\024\000b.npy\001\000\020\000\240\000\000\000\000\000\000\000\240\000\000\000\000\000\000\000"
+        "\223NUMPY\001\000v\000{'descr': '<f8', 'fortran_order': False, 'shape': (2, 2), }               "
+        "                                           \012\000\000\000\000\000\000\340\077\000\000\000\000"
+        "\000\000\370\077\000\000\000\000\000\000\004@\000\000\000\000\000\000\014@PK\001\002-\003-\000"
+        "\000\000\000\000\000\000!P\236\347y\020\377\377\377\377\377\377\377\377\005\000\024\000\000\000"
+        "\000\000\000\000\000\000\200\001\000\000\000\000a.npy\001\000\020\000\214\000\000\000\000\000"
+        "\000\000\214\000\000\000\000\000\000\000PK\001\002-\003-\000\000\000\000\000\000\000!P\351\362"
+        "\366\355\377\377\377\377\377\377\377\377\005\000\034\000\000\000\000\000\000\000\000\000\200\001"
+        "\377\377\377\377b.npy\001\000\030\000\240\000\000\000\000\000\000\000\240\000\000\000\000\000"
+        "\000\000\303\000\000\000\000\000\000\000PK\006\006,\000\000\000\000\000\000\000-\000-\000\000"
+        "\000\000\000\000\000\000\000\002\000\000\000\000\000\000\000\002\000\000\000\000\000\000\000\226"
+        "\000\000\000\000\000\000\000\232\001\000\000\000\000\000\000PK\006\007\000\000\000\0000\002\000"
+        "\000\000\000\000\000\001\000\000\000PK\005\006\000\000\000\000\002\000\002\000\226\000\000\000"
+        "\232\001\000\000\000\000";
+
+TEST(TIO, npz_reads_zip64_archive_written_by_python)
+{
+    TTempFile file("tio_python.npz");
+    {
+        std::ofstream os(file.path, std::ios::binary);
+        os.write(pythonNpz, sizeof(pythonNpz) - 1);
+    }
+    TNpzFile npz(file.path);
+    EXPECT_EQ(std::vector<std::string>({ "a", "b" }), npz.names());
+    EXPECT_TRUE(npz.contains("a.npy"));
+    EXPECT_FALSE(npz.contains("c"));
+
+    TDynamicVector<int32_t> a;
+    npz.read("a", a);
+    ASSERT_EQ(3u, a.size());
+    EXPECT_EQ(-2, a[1]);
+    EXPECT_EQ(3, a[2]);
+
+    TDynamicMatrix<double> b;
+    npz.read("b.npy", b);
+    ASSERT_EQ(2u, b.rows());
+    ASSERT_EQ(2u, b.cols());
+    EXPECT_EQ(1.5, b[0][1]);
+    EXPECT_EQ(2.5, b[1][0]);
+
+    ASSERT_ANY_THROW(npz.read("c", a));
+    ASSERT_ANY_THROW(npz.read("b", a));
+}
+
+TEST(TIO, npz_round_trip_aligns_members)
+{
+    TTempFile file("tio_round.npz");
+    TDynamicVector<float> v(7);
+    for (size_t i = 0; i < 7; i++)
+        v[i] = float(i) - 2.5f;
+    TDynamicMatrix<double> m = sample(5, 3);
+    {
+        TNpzWriter w(file.path);
+        w.add("vec", v);
+        w.add("mat.npy", m);
+        ASSERT_ANY_THROW(w.add("vec", v));
+        w.close();
+    }
+
+    TNpzFile npz(file.path);
+    EXPECT_EQ(std::vector<std::string>({ "vec", "mat" }), npz.names());
+    TDynamicVector<float> v1;
+    TDynamicMatrix<double> m1;
+    npz.read("vec", v1);
+    npz.read("mat", m1);
+    EXPECT_EQ(v, v1);
+    EXPECT_EQ(m, m1);
+
+    // the payload of every member starts on a BINARY_ALIGNMENT boundary
+    TMappedFile mapped(file.path);
+    const unsigned char* p = mapped.data();
+    for (const char* name : { "vec.npy", "mat.npy" }) {
+        const unsigned char* local = std::search(p, p + mapped.size(), name, name + 7) - 30;
+        size_t start = (local - p) + 30 + (local[26] | local[27] << 8) + (local[28] | local[29] << 8);
+        EXPECT_EQ(0u, start % BINARY_ALIGNMENT) << name;
+        EXPECT_EQ(0, std::memcmp(p + start, "\x93NUMPY", 6)) << name;
+    }
+}
+
+TEST(TIO, npz_rejects_compressed_members)
+{
+    TTempFile file("tio_deflate.npz");
+    {
+        TNpzWriter w(file.path);
+        w.add("a", sample(2, 2));
+        w.add("b", sample(3, 3));
+    }
+    // mark member "b" as deflated in the central directory
+    std::string data;
+    {
+        std::ifstream is(file.path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    size_t dir = data.find("PK\x01\x02", data.find("PK\x01\x02") + 4);
+    ASSERT_NE(std::string::npos, dir);
+    data[dir + 10] = 8;
+    {
+        std::ofstream os(file.path, std::ios::binary);
+        os << data;
+    }
+
+    TNpzFile npz(file.path);
+    TDynamicMatrix<double> m;
+    ASSERT_NO_THROW(npz.read("a", m));
+    EXPECT_EQ(sample(2, 2), m);
+    ASSERT_ANY_THROW(npz.read("b", m));
+}
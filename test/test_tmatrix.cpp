@@ -186,6 +186,411 @@ TEST(TDynamicMatrix, cant_subtract_matrices_with_not_equal_size)
     TDynamicMatrix<int> m1(2), m2(3);
     ASSERT_ANY_THROW(m1 - m2);
 }
+
+TEST(TDynamicMatrix, rows_are_stored_contiguously)
+{
+    TDynamicMatrix<int> m(4);
+    for (size_t i = 1; i < 4; i++)
+        EXPECT_EQ(m[i - 1].data() + 4, m[i].data());
+}
+
+TEST(TDynamicMatrix, assign_to_row_copies_elements)
+{
+    TDynamicMatrix<int> m(3);
+    TDynamicVector<int> v(3);
+    v[0] = 1; v[1] = 2; v[2] = 3;
+
+    m[1] = v;
+    m[2] = m[1];
+    m[1][0] = 10;
+
+    EXPECT_EQ(v, TDynamicVector<int>(m[2]));
+    EXPECT_EQ(10, m[1][0]);
+    ASSERT_ANY_THROW(m[0] = TDynamicVector<int>(4));
+}
+
+TEST(TDynamicMatrix, can_multiply_matrices_with_equal_size)
+{
+    TDynamicMatrix<int> m1(2), m2(2), expected(2);
+
+    m1[0][0] = 1; m1[0][1] = 2;
+    m1[1][0] = 3; m1[1][1] = 4;
+
+    m2[0][0] = 5; m2[0][1] = 6;
+    m2[1][0] = 7; m2[1][1] = 8;
+
+    expected[0][0] = 19; expected[0][1] = 22;
+    expected[1][0] = 43; expected[1][1] = 50;
+
+    EXPECT_EQ(expected, m1 * m2);
+}
+
+TEST(TDynamicMatrix, blocked_product_matches_naive_one)
+{
+    const size_t n = 131; //    
+    TDynamicMatrix<long long> m1(n), m2(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            m1[i][j] = (i * 7 + j * 3) % 11 - 5;
+            m2[i][j] = (i * 5 + j) % 13 - 6;
+        }
+
+    TDynamicMatrix<long long> res = m1 * m2;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            long long sum = 0;
+            for (size_t k = 0; k < n; k++)
+                sum += m1[i][k] * m2[k][j];
+            ASSERT_EQ(sum, res[i][j]);
+        }
+}
+
+
+TEST(TDynamicMatrix, gemm_overwrite_ignores_previous_content)
+{
+    for (size_t n : { 5, 131 }) {
+        TDynamicMatrix<long long> a(n), b(n), c(n), expected(n);
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++) {
+                a[i][j] = (i + 2 * j) % 7 - 3;
+                b[i][j] = (3 * i + j) % 5 - 2;
+                c[i][j] = 12345; // ,    
+            }
+        gemm(n, n, n, a.data(), a.ld(), b.data(), b.ld(), expected.data(), expected.ld());
+        gemm(n, n, n, a.data(), a.ld(), b.data(), b.ld(), c.data(), c.ld(), true);
+        EXPECT_EQ(expected, c);
+    }
+}
+
+TEST(TDynamicMatrix, can_multiply_matrix_by_vector)
+{
+    TDynamicMatrix<int> m(2);
+    m[0][0] = 1; m[0][1] = 2;
+    m[1][0] = 3; m[1][1] = 4;
+    TDynamicVector<int> v(2);
+    v[0] = 5; v[1] = 6;
+
+    TDynamicVector<int> res = m * v;
+    EXPECT_EQ(17, res[0]);
+    EXPECT_EQ(39, res[1]);
+}
+
+TEST(TDynamicMatrix, can_evaluate_fused_expression)
+{
+    TDynamicMatrix<int> m1(2), m2(2), m3(2), expected(2);
+
+    m1[0][0] = 1; m1[0][1] = 2;
+    m1[1][0] = 3; m1[1][1] = 4;
+
+    m2[0][0] = 5; m2[0][1] = 6;
+    m2[1][0] = 7; m2[1][1] = 8;
+
+    m3[0][0] = 1; m3[0][1] = 1;
+    m3[1][0] = 1; m3[1][1] = 1;
+
+    expected[0][0] = 10; expected[0][1] = 13;
+    expected[1][0] = 16; expected[1][1] = 19;
+
+    TDynamicMatrix<int> result = m1 + m2 * 2 - m3;
+    EXPECT_EQ(expected, result);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrix_expressions)
+{
+    TDynamicMatrix<int> m1(2), m2(2), expected(2);
+
+    m1[0][0] = 1; m1[0][1] = 2;
+    m1[1][0] = 3; m1[1][1] = 4;
+
+    m2[0][0] = 1; m2[0][1] = 0;
+    m2[1][0] = 0; m2[1][1] = 1;
+
+    expected[0][0] = 4; expected[0][1] = 8;
+    expected[1][0] = 12; expected[1][1] = 16;
+
+    EXPECT_EQ(expected, (m1 + m2) * (m1 - m2 * 2));
+
+    TDynamicVector<int> v(2);
+    v[0] = 1; v[1] = 1;
+    TDynamicVector<int> res = (m1 - m2) * (v + v);
+    EXPECT_EQ(4, res[0]);
+    EXPECT_EQ(12, res[1]);
+}
+
+TEST(TDynamicMatrix, compound_assignment_works_in_place)
+{
+    TDynamicMatrix<int> m1(2), m2(2), expected(2);
+
+    m1[0][0] = 1; m1[0][1] = 2;
+    m1[1][0] = 3; m1[1][1] = 4;
+
+    m2[0][0] = 5; m2[0][1] = 6;
+    m2[1][0] = 7; m2[1][1] = 8;
+
+    expected[0][0] = 12; expected[0][1] = 16;
+    expected[1][0] = 20; expected[1][1] = 24;
+
+    const int* mem = m1.data();
+    m1 += m2;
+    m1 -= m2 * 0 + m1 * 0;
+    m1 *= 4;
+    m1 /= 2;
+
+    EXPECT_EQ(expected, m1);
+    EXPECT_EQ(mem, m1.data());
+
+    TDynamicMatrix<int> m3(3);
+    ASSERT_ANY_THROW(m1 += m3);
+}
+
+TEST(TDynamicMatrix, can_create_rectangular_matrix)
+{
+    TDynamicMatrix<int> m(2, 5);
+    EXPECT_EQ(2, m.rows());
+    EXPECT_EQ(5, m.cols());
+    EXPECT_EQ(5, m[1].size());
+    ASSERT_ANY_THROW(m.at(2));
+}
+
+TEST(TDynamicMatrix, tall_matrix_is_limited_by_element_count)
+{
+    ASSERT_NO_THROW(TDynamicMatrix<char> m(MAX_MATRIX_SIZE * 10, 2));
+    ASSERT_ANY_THROW(TDynamicMatrix<char> m(MAX_VECTOR_SIZE, 2));
+    ASSERT_ANY_THROW(TDynamicMatrix<char> m(0, 2));
+}
+
+TEST(TDynamicMatrix, rectangular_matrices_with_different_shape_are_not_equal)
+{
+    TDynamicMatrix<int> m1(2, 3), m2(3, 2);
+    EXPECT_NE(m1, m2);
+    ASSERT_ANY_THROW(m1 + m2);
+}
+
+TEST(TDynamicMatrix, can_multiply_rectangular_matrices)
+{
+    TDynamicMatrix<int> m1(2, 3), m2(3, 1), expected(2, 1);
+    m1[0][0] = 1; m1[0][1] = 2; m1[0][2] = 3;
+    m1[1][0] = 4; m1[1][1] = 5; m1[1][2] = 6;
+    m2[0][0] = 1; m2[1][0] = 0; m2[2][0] = -1;
+    expected[0][0] = -2; expected[1][0] = -2;
+
+    EXPECT_EQ(expected, m1 * m2);
+    ASSERT_ANY_THROW(m1 * m1);
+}
+
+TEST(TDynamicMatrix, can_multiply_tall_skinny_matrices)
+{
+    const size_t m = 700, k = 64, n = 8;
+    TDynamicMatrix<long long> a(m, k), b(k, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t p = 0; p < k; p++)
+            a[i][p] = (i * 3 + p) % 7 - 3;
+    for (size_t p = 0; p < k; p++)
+        for (size_t j = 0; j < n; j++)
+            b[p][j] = (p + j * 5) % 4 - 1;
+
+    TDynamicMatrix<long long> c = a * b;
+    ASSERT_EQ(m, c.rows());
+    ASSERT_EQ(n, c.cols());
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            long long sum = 0;
+            for (size_t p = 0; p < k; p++)
+                sum += a[i][p] * b[p][j];
+            ASSERT_EQ(sum, c[i][j]);
+        }
+}
+
+TEST(TDynamicMatrix, can_multiply_rectangular_matrix_by_vector)
+{
+    TDynamicMatrix<int> m(3, 2);
+    m[0][0] = 1; m[0][1] = 2;
+    m[1][0] = 3; m[1][1] = 4;
+    m[2][0] = 5; m[2][1] = 6;
+    TDynamicVector<int> v(2);
+    v[0] = 1; v[1] = -1;
+
+    TDynamicVector<int> res = m * v;
+    ASSERT_EQ(3, res.size());
+    EXPECT_EQ(-1, res[0]);
+    EXPECT_EQ(-1, res[1]);
+    EXPECT_EQ(-1, res[2]);
+    ASSERT_ANY_THROW(m * TDynamicVector<int>(3));
+}
+
+TEST(TDynamicMatrix, throws_when_multiply_result_aliases_vector)
+{
+    TDynamicMatrix<int> m(3);
+    TDynamicVector<int> v(3), res(3);
+    ASSERT_ANY_THROW(m.multiply(v, v));
+    ASSERT_NO_THROW(m.multiply(v, res));
+}
+
+TEST(TDynamicMatrix, input_output_of_rectangular_matrix)
+{
+    TDynamicMatrix<int> m(2, 3);
+    for (size_t i = 0; i < 2; i++)
+        for (size_t j = 0; j < 3; j++)
+            m[i][j] = int(i * 3 + j);
+
+    std::stringstream ss;
+    ss << m;
+    TDynamicMatrix<int> m1(2, 3);
+    ss >> m1;
+    EXPECT_EQ(m, m1);
+}
+
+TEST(TDynamicMatrix, large_text_output_is_parallel_and_row_ordered)
+{
+    // more elements than the serial threshold, rows padded to ld()
+    TDynamicMatrix<int> m(300, 301, TDynamicMatrix<int>::paddedLd(301));
+    for (size_t i = 0; i < 300; i++)
+        for (size_t j = 0; j < 301; j++)
+            m[i][j] = int(i * 1000 + j) - 150000;
+
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(4);
+    std::stringstream ss;
+    ss << m;
+    pool.setThreadCount(old);
+
+    std::string first;
+    std::getline(ss, first);
+    EXPECT_EQ('\n', ss.str().back());
+    std::stringstream line(first);
+    int a, b;
+    line >> a >> b;
+    EXPECT_EQ(-150000, a);
+    EXPECT_EQ(-149999, b);
+
+    std::stringstream all(ss.str());
+    TDynamicMatrix<int> m1(300, 301);
+    all >> m1;
+    EXPECT_EQ(m, m1);
+}
+
+TEST(TDynamicMatrix, submatrix_shares_memory_with_matrix)
+{
+    TDynamicMatrix<int> m(4);
+    TMatrixView<int> v = m.submatrix(1, 2, 2, 2);
+    v[0][0] = 5;
+    v(1, 1) = 7;
+
+    EXPECT_EQ(5, m[1][2]);
+    EXPECT_EQ(7, m[2][3]);
+    EXPECT_EQ(4, v.ld());
+    ASSERT_ANY_THROW(m.submatrix(3, 3, 2, 1));
+}
+
+TEST(TDynamicMatrix, can_assign_expression_to_submatrix)
+{
+    TDynamicMatrix<int> m(3), block(2);
+    block[0][0] = 1; block[0][1] = 2;
+    block[1][0] = 3; block[1][1] = 4;
+
+    m.submatrix(1, 1, 2, 2) = block * 2;
+    m.submatrix(0, 0, 2, 2) += block;
+
+    EXPECT_EQ(1, m[0][0]);
+    EXPECT_EQ(2, m[0][1]);
+    EXPECT_EQ(3, m[1][0]);
+    EXPECT_EQ(6, m[1][1]);
+    EXPECT_EQ(4, m[1][2]);
+    EXPECT_EQ(8, m[2][2]);
+    ASSERT_ANY_THROW(m.submatrix(0, 0, 1, 2) = block);
+}
+
+TEST(TDynamicMatrix, can_multiply_submatrices_without_copy)
+{
+    const size_t n = 150;
+    TDynamicMatrix<long long> m(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            m[i][j] = (i * 7 + j * 3) % 11 - 5;
+
+    TMatrixView<const long long> a = static_cast<const TDynamicMatrix<long long>&>(m).submatrix(3, 5, 90, 70);
+    TMatrixView<long long> b = m.submatrix(10, 1, 70, 80);
+    TDynamicMatrix<long long> expected = TDynamicMatrix<long long>(a) * TDynamicMatrix<long long>(b);
+
+    EXPECT_EQ(expected, a * b);
+    EXPECT_EQ(expected, a * TDynamicMatrix<long long>(b));
+}
+
+TEST(TDynamicMatrix, column_view_accesses_matrix_column)
+{
+    TDynamicMatrix<int> m(3);
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            m[i][j] = int(i * 3 + j);
+
+    TDynamicVector<int> col = m.column(1);
+    EXPECT_EQ(1, col[0]);
+    EXPECT_EQ(4, col[1]);
+    EXPECT_EQ(7, col[2]);
+
+    m.column(2) = m.column(0) + m.column(1);
+    EXPECT_EQ(1, m[0][2]);
+    EXPECT_EQ(7, m[1][2]);
+    EXPECT_EQ(13, m[2][2]);
+    EXPECT_EQ(120, m.column(1) * m.column(2));
+    ASSERT_ANY_THROW(m.column(3));
+}
+
+TEST(TDynamicMatrix, can_multiply_submatrix_by_vector)
+{
+    TDynamicMatrix<int> m(3);
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            m[i][j] = int(i * 3 + j);
+    TDynamicVector<int> v(2);
+    v[0] = 1; v[1] = 1;
+
+    TDynamicVector<int> res = m.submatrix(1, 1, 2, 2) * v;
+    EXPECT_EQ(9, res[0]);
+    EXPECT_EQ(15, res[1]);
+}
+
+
+TEST(TDynamicMatrix, padded_ld_aligns_rows_and_breaks_power_of_two)
+{
+    EXPECT_EQ(8u, TDynamicMatrix<double>::paddedLd(5));
+    EXPECT_EQ(104u, TDynamicMatrix<double>::paddedLd(100));
+    EXPECT_EQ(520u, TDynamicMatrix<double>::paddedLd(512));
+    EXPECT_EQ(1040u, TDynamicMatrix<float>::paddedLd(1024));
+
+    size_t ld = TDynamicMatrix<double>::paddedLd(100);
+    TDynamicMatrix<double> m(3, 100, ld);
+    EXPECT_EQ(ld, m.ld());
+    for (size_t i = 0; i < m.rows(); i++)
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(m[i].data()) % MEMORY_ALIGNMENT);
+}
+
+TEST(TDynamicMatrix, throws_when_ld_is_less_than_cols)
+{
+    ASSERT_ANY_THROW(TDynamicMatrix<int> m(3, 4, 3));
+}
+
+TEST(TDynamicMatrix, padded_matrix_works_like_dense_one)
+{
+    const size_t r = 5, c = 7;
+    TDynamicMatrix<int> p(r, c, TDynamicMatrix<int>::paddedLd(c)), d(r, c), v(c, 3);
+    for (size_t i = 0; i < r; i++)
+        for (size_t j = 0; j < c; j++)
+            p[i][j] = d[i][j] = int(i * c + j) - 10;
+    for (size_t i = 0; i < c; i++)
+        for (size_t j = 0; j < 3; j++)
+            v[i][j] = int(i + 2 * j) % 4;
+
+    EXPECT_EQ(d, p);
+    EXPECT_EQ(d * v, p * v);
+    EXPECT_EQ(TDynamicMatrix<int>(d + d * 2), TDynamicMatrix<int>(p + p * 2));
+    p *= 3;
+    d *= 3;
+    p -= d;
+    EXPECT_EQ(TDynamicMatrix<int>(r, c), p);
+    EXPECT_EQ(0, p.column(2)[4]);
+}
 /////////////////////////////////////////////////////////////////////////////////
 //  
 
@@ -223,6 +628,73 @@ TEST(TUpperTriangularMatrix, ErrorHandling) {
     TDynamicVector<int> v(3);
     EXPECT_ANY_THROW(m * v);
 }
+
+
+TEST(TUpperTriangularMatrix, CompoundAssignment) {
+    TUpperTriangularMatrix<int> m1(2), m2(2);
+    m1.at(0, 0) = 1; m1.at(0, 1) = 2; m1.at(1, 1) = 3;
+    m2.at(0, 0) = 4; m2.at(0, 1) = 5; m2.at(1, 1) = 6;
+
+    m1 += m2;
+    m1 *= 2;
+    m1 -= m2;
+    m1 /= 2;
+
+    EXPECT_EQ(3, m1.at(0, 0));
+    EXPECT_EQ(4, m1.at(0, 1));
+    EXPECT_EQ(6, m1.at(1, 1));
+
+    TUpperTriangularMatrix<int> m3(3);
+    EXPECT_ANY_THROW(m1 += m3);
+}
+
+TEST(TUpperTriangularMatrix, BackSubstitution) {
+    TUpperTriangularMatrix<double> m(3);
+    m.at(0, 0) = 2; m.at(0, 1) = 1; m.at(0, 2) = -1;
+    m.at(1, 1) = 4; m.at(1, 2) = 2;
+    m.at(2, 2) = 5;
+    TDynamicVector<double> x(3);
+    x[0] = 1; x[1] = -2; x[2] = 3;
+
+    TDynamicVector<double> b = m * x;
+    EXPECT_EQ(x, m.solve(b));
+    m.solve(b, b);
+    EXPECT_EQ(x, b);
+
+    TUpperTriangularMatrix<double> s(2);
+    s.at(0, 0) = 1;
+    EXPECT_ANY_THROW(s.solve(TDynamicVector<double>(2)));
+}
+
+TEST(TUpperTriangularMatrix, BlockedProductMatchesDense) {
+    const size_t n = 300, m = 7;
+    TUpperTriangularMatrix<long long> a(n);
+    TDynamicMatrix<long long> dense(n), b(n, m);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i; j < n; j++)
+            a.at(i, j) = dense[i][j] = (long long)((i * 5 + j * 3) % 7) - 3;
+        for (size_t k = 0; k < m; k++)
+            b[i][k] = (long long)((i + 2 * k) % 5) - 2;
+    }
+    EXPECT_EQ(dense * b, a * b);
+}
+
+TEST(TUpperTriangularMatrix, BlockedSolveInvertsProduct) {
+    const size_t n = 300, m = 5;
+    TUpperTriangularMatrix<double> a(n);
+    TDynamicMatrix<double> x(n, m);
+    for (size_t i = 0; i < n; i++) {
+        a.at(i, i) = 4;
+        for (size_t j = i + 1; j < n; j++)
+            a.at(i, j) = ((i + j) % 3 == 0) ? 0.01 : 0.0;
+        for (size_t k = 0; k < m; k++)
+            x[i][k] = double((i * 3 + k) % 7) - 3;
+    }
+    TDynamicMatrix<double> res = a.solve(a * x);
+    for (size_t i = 0; i < n; i++)
+        for (size_t k = 0; k < m; k++)
+            EXPECT_NEAR(x[i][k], res[i][k], 1e-9);
+}
 //    
 TEST(TBandMatrix, can_create_matrix_with_positive_length)
 {
@@ -255,6 +727,154 @@ TEST(TBandMatrix, throws_when_set_element_outside_band)
     ASSERT_ANY_THROW(m.at(0, 2));
     ASSERT_ANY_THROW(m.at(2, 0));
 }
+
+
+TEST(TBandMatrix, can_add_matrices_in_place)
+{
+    TBandMatrix<int> m1(3, 1), m2(3, 1), narrow(3, 0);
+    m1.at(0, 1) = 1; m1.at(1, 1) = 2;
+    m2.at(0, 1) = 3; m2.at(2, 1) = 4;
+    narrow.at(1, 1) = 10;
+
+    m1 += m2;
+    m1 -= narrow;
+    m1 *= 3;
+
+    EXPECT_EQ(12, m1.at(0, 1));
+    EXPECT_EQ(-24, m1.at(1, 1));
+    EXPECT_EQ(12, m1.at(2, 1));
+    EXPECT_EQ(0, m1.at(0, 0));
+}
+
+TEST(TBandMatrix, cant_add_matrix_with_wider_band)
+{
+    TBandMatrix<int> m1(3, 1), m2(3, 2);
+    ASSERT_ANY_THROW(m1 += m2);
+}
+
+TEST(TBandMatrix, can_create_asymmetric_band)
+{
+    TBandMatrix<int> m(6, 1, 4);
+    EXPECT_EQ(1u, m.lowerBandWidth());
+    EXPECT_EQ(4u, m.upperBandWidth());
+    ASSERT_NO_THROW(m.at(0, 4));
+    ASSERT_NO_THROW(m.at(3, 2));
+    ASSERT_ANY_THROW(m.at(3, 1));
+    ASSERT_ANY_THROW(m.at(0, 5));
+    EXPECT_EQ(0, static_cast<const TBandMatrix<int>&>(m).at(0, 5));
+    ASSERT_ANY_THROW(TBandMatrix<int>(4, 1, 4));
+}
+
+TEST(TBandMatrix, asymmetric_band_product_matches_dense)
+{
+    const size_t n = 9;
+    TBandMatrix<int> m(n, 1, 4);
+    TDynamicMatrix<int> dense(n);
+    TDynamicVector<int> v(n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = (i > 0 ? i - 1 : 0); j < n && j <= i + 4; j++)
+            m.at(i, j) = dense[i][j] = int(i * 3 + j) % 7 - 3;
+        v[i] = int(i % 4) - 1;
+    }
+    EXPECT_EQ(dense * v, m * v);
+}
+
+TEST(TBandMatrix, can_add_nested_asymmetric_band)
+{
+    TBandMatrix<int> m1(5, 1, 3), m2(5, 0, 2);
+    m1.at(1, 0) = 1; m1.at(1, 4) = 2;
+    m2.at(1, 1) = 5; m2.at(1, 3) = 7;
+    m1 -= m2;
+    EXPECT_EQ(1, m1.at(1, 0));
+    EXPECT_EQ(-5, m1.at(1, 1));
+    EXPECT_EQ(-7, m1.at(1, 3));
+    EXPECT_EQ(2, m1.at(1, 4));
+    ASSERT_ANY_THROW(m2 += m1);
+}
+
+TEST(TBandLU, thomas_solves_tridiagonal_system)
+{
+    const size_t n = 50;
+    TBandMatrix<double> m(n, 1);
+    TDynamicVector<double> x(n);
+    for (size_t i = 0; i < n; i++) {
+        m.at(i, i) = 2;
+        if (i > 0) m.at(i, i - 1) = -1;
+        if (i + 1 < n) m.at(i, i + 1) = -1;
+        x[i] = double(i % 4) - 1;
+    }
+    TBandLU<double> lu(m);
+    TDynamicVector<double> res = lu.solve(m * x);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(x[i], res[i], 1e-9);
+}
+
+TEST(TBandLU, pivots_when_diagonal_is_zero)
+{
+    TBandMatrix<double> m(3, 1);
+    m.at(0, 1) = 1;
+    m.at(1, 0) = 1; m.at(1, 2) = 1;
+    m.at(2, 1) = 1; m.at(2, 2) = 1;
+    TDynamicVector<double> x(3);
+    x[0] = 1; x[1] = -2; x[2] = 3;
+
+    TDynamicVector<double> res = TBandLU<double>(m).solve(m * x);
+    for (size_t i = 0; i < 3; i++)
+        EXPECT_NEAR(x[i], res[i], 1e-12);
+}
+
+TEST(TBandLU, solves_wide_band_for_many_right_hand_sides)
+{
+    const size_t n = 40, bw = 3;
+    TBandMatrix<double> m(n, bw);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = (i > bw ? i - bw : 0); j < n && j <= i + bw; j++)
+            m.at(i, j) = double((i * 7 + j * 3) % 11) - 5;
+    TBandLU<double> lu(m);
+
+    for (size_t k = 0; k < 3; k++) {
+        TDynamicVector<double> x(n);
+        for (size_t i = 0; i < n; i++)
+            x[i] = double((i + k) % 5) - 2;
+        TDynamicVector<double> b = m * x;
+        lu.solve(b, b);
+        for (size_t i = 0; i < n; i++)
+            EXPECT_NEAR(x[i], b[i], 1e-8);
+    }
+}
+
+TEST(TBandLU, solves_asymmetric_band)
+{
+    const size_t n = 30;
+    TBandMatrix<double> m(n, 1, 4);
+    TDynamicVector<double> x(n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = (i > 0 ? i - 1 : 0); j < n && j <= i + 4; j++)
+            m.at(i, j) = double((i * 5 + j * 2) % 9) - 4 + (i == j ? 0.5 : 0);
+        x[i] = double(i % 6) - 2;
+    }
+    TDynamicVector<double> res = TBandLU<double>(m).solve(m * x);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(x[i], res[i], 1e-8);
+}
+
+TEST(TBandLU, throws_when_matrix_is_singular)
+{
+    TBandMatrix<double> m(3, 1);
+    m.at(0, 0) = 1; m.at(0, 1) = 2;
+    m.at(1, 0) = 2; m.at(1, 1) = 4;
+    m.at(2, 2) = 1;
+    ASSERT_ANY_THROW(TBandLU<double> lu(m));
+}
+
+TEST(TBandLU, throws_when_rhs_size_differs)
+{
+    TBandMatrix<double> m(3, 1);
+    for (size_t i = 0; i < 3; i++)
+        m.at(i, i) = 1;
+    TBandLU<double> lu(m);
+    ASSERT_ANY_THROW(lu.solve(TDynamicVector<double>(4)));
+}
 /*
 TEST(TBandMatrix, can_multiply_by_vector)
 {
@@ -349,6 +969,273 @@ TEST(TCSRMatrix, throws_when_set_element_with_invalid_index)
     ASSERT_ANY_THROW(csr.set(0, 2, 1));
 }
 
+
+TEST(TCSRMatrix, can_add_matrices_with_same_structure_in_place)
+{
+    TDynamicMatrix<int> dense(2);
+    dense[0][1] = 2;
+    dense[1][0] = 3;
+
+    TCSRMatrix<int> m1(dense), m2(dense);
+    m1 += m2;
+    m1 *= 2;
+    m1 -= m2;
+
+    EXPECT_EQ(2, m1.nonZeros());
+    EXPECT_EQ(6, m1.at(0, 1));
+    EXPECT_EQ(9, m1.at(1, 0));
+}
+
+TEST(TCSRMatrix, can_add_matrices_with_different_structure)
+{
+    TDynamicMatrix<int> d1(3), d2(3);
+    d1[0][0] = 1; d1[1][2] = 2;
+    d2[0][0] = 5; d2[0][2] = 3; d2[2][1] = 4;
+
+    TCSRMatrix<int> m1(d1), m2(d2);
+    m1 -= m2;
+
+    EXPECT_EQ(4, m1.nonZeros());
+    EXPECT_EQ(-4, m1.at(0, 0));
+    EXPECT_EQ(-3, m1.at(0, 2));
+    EXPECT_EQ(2, m1.at(1, 2));
+    EXPECT_EQ(-4, m1.at(2, 1));
+    EXPECT_EQ(0, m1.at(1, 1));
+}
+
+TEST(TCSRMatrix, set_keeps_rows_sorted_and_removes_zeros)
+{
+    TCSRMatrix<int> csr(3);
+    csr.set(1, 2, 5);
+    csr.set(1, 0, 4);
+    csr.set(0, 1, 1);
+    csr.set(2, 2, 6);
+    csr.set(1, 1, 7);
+    EXPECT_EQ(5, csr.nonZeros());
+
+    TDynamicVector<int> v(3), res(3);
+    v[0] = 1; v[1] = 2; v[2] = 3;
+    res[0] = 2; res[1] = 4 + 14 + 15; res[2] = 18;
+    EXPECT_EQ(res, csr * v);
+
+    csr.set(1, 1, 0);
+    csr.set(0, 0, 0);
+    EXPECT_EQ(4, csr.nonZeros());
+    EXPECT_EQ(0, csr.at(1, 1));
+    EXPECT_EQ(5, csr.at(1, 2));
+}
+
+TEST(TCSRBuilder, throws_when_add_with_invalid_index)
+{
+    TCSRBuilder<int> b(3);
+    ASSERT_ANY_THROW(b.add(3, 0, 1));
+    ASSERT_ANY_THROW(b.add(0, 3, 1));
+    ASSERT_ANY_THROW(TCSRBuilder<int> e(0));
+}
+
+TEST(TCSRBuilder, builds_from_unordered_triplets_and_sums_duplicates)
+{
+    TCSRBuilder<int> b(3);
+    b.add(2, 1, 4);
+    b.add(0, 2, 3);
+    b.add(0, 0, 1);
+    b.add(2, 1, 1);
+    b.add(1, 1, 2);
+    b.add(1, 1, -2);
+    b.add(0, 2, 3);
+
+    TCSRMatrix<int> csr(b);
+    EXPECT_EQ(3, csr.nonZeros());
+    EXPECT_EQ(1, csr.at(0, 0));
+    EXPECT_EQ(6, csr.at(0, 2));
+    EXPECT_EQ(0, csr.at(1, 1));
+    EXPECT_EQ(5, csr.at(2, 1));
+}
+
+TEST(TCSRBuilder, matches_dense_conversion)
+{
+    const size_t n = 50;
+    TDynamicMatrix<int> dense(n);
+    TCSRBuilder<int> b(n);
+    for (size_t k = 0; k < 400; k++) {
+        size_t i = (k * 37) % n, j = (k * 11 + 3) % n;
+        int val = int(k % 7) - 3;
+        dense[i][j] += val;
+        b.add(i, j, val);
+    }
+    TCSRMatrix<int> fromDense(dense), built = b.build();
+    EXPECT_EQ(fromDense.nonZeros(), built.nonZeros());
+
+    TDynamicVector<int> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = int(i % 5) + 1;
+    EXPECT_EQ(fromDense * v, built * v);
+}
+
+TEST(TCSRMatrix, throws_when_size_does_not_fit_index_type)
+{
+    ASSERT_ANY_THROW((TCSRMatrix<float, uint16_t>(70000)));
+    ASSERT_ANY_THROW((TCSRBuilder<float, uint16_t>(70000)));
+    ASSERT_NO_THROW((TCSRMatrix<float, uint16_t>(65535)));
+}
+
+TEST(TCSRMatrix, wide_index_type_gives_same_result)
+{
+    const size_t n = 40;
+    TCSRBuilder<double> b32(n);
+    TCSRBuilder<double, size_t> b64(n);
+    for (size_t k = 0; k < 200; k++) {
+        size_t i = (k * 13) % n, j = (k * 7 + 1) % n;
+        b32.add(i, j, 0.5 * k);
+        b64.add(i, j, 0.5 * k);
+    }
+    TCSRMatrix<double> m32(b32);
+    TCSRMatrix<double, size_t> m64(b64);
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = double(i) - 20;
+
+    EXPECT_EQ(m64.nonZeros(), m32.nonZeros());
+    EXPECT_EQ(m64 * v, m32 * v);
+}
+
+TEST(TCSRMatrix, parallel_spmv_matches_serial_one)
+{
+    //      
+    const size_t n = 20000;
+    TCSRBuilder<long long> b(n);
+    for (size_t j = 0; j < n; j += 2)
+        b.add(7, j, (j % 9) - 4);
+    for (size_t i = 0; i < n; i++) {
+        b.add(i, i, 3);
+        b.add(i, (i * 31 + 5) % n, (i % 5) - 2);
+    }
+    TCSRMatrix<long long> m = b.build();
+    TDynamicVector<long long> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = (i % 7) - 3;
+
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(1);
+    TDynamicVector<long long> serial = m * v;
+    pool.setThreadCount(6);
+    TDynamicVector<long long> parallel = m * v;
+    pool.setThreadCount(old);
+
+    EXPECT_EQ(serial, parallel);
+}
+
+TEST(TCSRMatrix, throws_when_multiply_result_aliases_vector)
+{
+    TCSRBuilder<double> b(4);
+    for (size_t i = 0; i < 4; i++)
+        b.add(i, 3 - i, 1.0);
+    TCSRMatrix<double> m(b);
+    TDynamicVector<double> v(4);
+    ASSERT_ANY_THROW(m.multiply(v, v));
+    ASSERT_ANY_THROW(m.view().multiply(v, v));
+}
+
+TEST(TCSRMatrix, move_assignment_does_not_copy_arrays)
+{
+    static_assert(std::is_nothrow_move_constructible<TCSRMatrix<double>>::value, "");
+    static_assert(std::is_nothrow_move_assignable<TCSRMatrix<double>>::value, "");
+    TCSRBuilder<double> b(5);
+    b.add(0, 1, 2.0);
+    b.add(3, 4, -1.0);
+    TCSRMatrix<double> a(b), c(2);
+    const double* p = a.view().values();
+    c = std::move(a);
+    EXPECT_EQ(5u, c.size());
+    EXPECT_EQ(2u, c.nonZeros());
+    EXPECT_EQ(p, c.view().values());
+    EXPECT_EQ(-1.0, c.at(3, 4));
+}
+
+TEST(TSellMatrix, throws_when_sigma_is_zero)
+{
+    TCSRMatrix<double> csr(4);
+    ASSERT_ANY_THROW(TSellMatrix<double> m(csr, 0));
+}
+
+TEST(TSellMatrix, throws_when_multiply_result_aliases_vector)
+{
+    TCSRBuilder<double> b(20);
+    for (size_t i = 0; i < 20; i++)
+        b.add(i, (i * 7) % 20, 2.0);
+    TSellMatrix<double> m{TCSRMatrix<double>(b)};
+    TDynamicVector<double> v(20);
+    ASSERT_ANY_THROW(m.multiply(v, v));
+}
+
+TEST(TSellMatrix, product_matches_csr_one)
+{
+    const size_t n = 103;
+    TCSRBuilder<double> b(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t k = 0; k < i % 6; k++)
+            b.add(i, (i * 17 + k * 29) % n, 0.25 * double(int(i + k) % 9 - 4));
+    TCSRMatrix<double> csr(b);
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = double(i % 11) - 5;
+
+    for (size_t sigma : { 1, 8, 32, 1000 }) {
+        TSellMatrix<double> sell(csr, sigma);
+        EXPECT_EQ(csr.nonZeros(), sell.nonZeros());
+        EXPECT_GE(sell.storedElements(), sell.nonZeros());
+        EXPECT_EQ(csr * v, sell * v);
+    }
+}
+
+TEST(TSellMatrix, sorting_reduces_padding)
+{
+    const size_t n = 64;
+    TCSRBuilder<float> b(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t k = 0; k <= (i % 8 == 0 ? 7 : 0); k++)
+            b.add(i, (i + k) % n, 1.0f);
+    TCSRMatrix<float> csr(b);
+
+    TSellMatrix<float> unsorted(csr, 1), sorted(csr, n);
+    EXPECT_EQ(8u * n, unsorted.storedElements());
+    EXPECT_EQ(csr.nonZeros(), sorted.storedElements());
+}
+
+TEST(TSellMatrix, parallel_sell_spmv_matches_csr_one)
+{
+    const size_t n = 30000;
+    TCSRBuilder<float> b(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t k = 0; k < 3 + i % 4; k++)
+            b.add(i, (i * 13 + k * 101) % n, float(int(i + k) % 5 - 2));
+    TCSRMatrix<float> csr(b);
+    TSellMatrix<float> sell(csr);
+    TDynamicVector<float> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = float(i % 3);
+
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(1);
+    TDynamicVector<float> serial = csr * v;
+    pool.setThreadCount(4);
+    TDynamicVector<float> parallel = sell * v;
+    pool.setThreadCount(old);
+
+    EXPECT_EQ(serial, parallel);
+}
+
+TEST(TCSRBuilder, can_build_empty_matrix)
+{
+    TCSRBuilder<int> b(4);
+    b.add(1, 2, 0);
+    TCSRMatrix<int> csr = b.build();
+    EXPECT_EQ(0, csr.nonZeros());
+    EXPECT_EQ(0, csr.at(1, 2));
+}
+
 //    
 TEST(MatrixFormats, multiplication_comparison)
 {
@@ -403,4 +1290,31 @@ TEST(MatrixFormats, multiplication_comparison)
         EXPECT_EQ(result_dense[i], result_band[i]);
         EXPECT_EQ(result_dense[i], result_csr[i]);
     }
-}
\ No newline at end of file
+}
+
+TEST(TDynamicMatrix, expiring_operand_buffer_is_reused)
+{
+    TDynamicMatrix<double> a(5, 7, 8), b(5, 7), c(5, 7);
+    for (size_t i = 0; i < 5; i++)
+        for (size_t j = 0; j < 7; j++) {
+            a[i][j] = double(i * 7 + j);
+            b[i][j] = double(j) - 3;
+            c[i][j] = double(i) * 0.25;
+        }
+    TDynamicMatrix<double> expected(5, 7);
+    for (size_t i = 0; i < 5; i++)
+        for (size_t j = 0; j < 7; j++)
+            expected[i][j] = (a[i][j] + b[i][j] - c[i][j]) * 2;
+
+    const double* buf = a.data();
+    TDynamicMatrix<double> r = (std::move(a) + b - c) * 2.0;
+    EXPECT_EQ(buf, r.data());
+    EXPECT_EQ(8u, r.ld());
+    EXPECT_EQ(expected, r);
+
+    TDynamicMatrix<double> s = b - TDynamicMatrix<double>(r);
+    for (size_t i = 0; i < 5; i++)
+        for (size_t j = 0; j < 7; j++)
+            EXPECT_EQ(b[i][j] - expected[i][j], s[i][j]);
+    ASSERT_ANY_THROW(TDynamicMatrix<double>(4, 7) + b);
+}
@@ -0,0 +1,76 @@
+#include "tmatrix.h"
+#include <gtest.h>
+
+template<typename T>
+void checkKernelsAtAllLevels()
+{
+    const size_t n = 103; //     
+    TDynamicVector<T> a(n), b(n);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = static_cast<T>(i % 17) - 8;
+        b[i] = static_cast<T>((i * 5) % 11) - 5;
+    }
+
+    TSimdLevel old = simdLevel();
+    for (int lvl = SIMD_NONE; lvl <= supportedSimdLevel(); lvl++) {
+        setSimdLevel(static_cast<TSimdLevel>(lvl));
+        TDynamicVector<T> sum = a + b, diff = a - b;
+        TDynamicVector<T> plus = a + T(3), minus = a - T(3), scaled = a * T(3);
+        TDynamicVector<T> fma(b);
+        simdMulAdd(a.data(), b.data(), fma.data(), n);
+        TDynamicVector<T> axpy(n);
+        simdAxpy(a.data(), T(-3), b.data(), axpy.data(), n);
+        T dot = a * b, expectedDot = T();
+        for (size_t i = 0; i < n; i++) {
+            ASSERT_EQ(a[i] + b[i], sum[i]) << "level " << lvl;
+            ASSERT_EQ(a[i] - b[i], diff[i]) << "level " << lvl;
+            ASSERT_EQ(a[i] + T(3), plus[i]) << "level " << lvl;
+            ASSERT_EQ(a[i] - T(3), minus[i]) << "level " << lvl;
+            ASSERT_EQ(a[i] * T(3), scaled[i]) << "level " << lvl;
+            ASSERT_EQ(b[i] + a[i] * b[i], fma[i]) << "level " << lvl;
+            ASSERT_EQ(a[i] + T(-3) * b[i], axpy[i]) << "level " << lvl;
+            expectedDot += a[i] * b[i];
+        }
+        EXPECT_EQ(expectedDot, dot) << "level " << lvl;
+    }
+    setSimdLevel(old);
+}
+
+TEST(TSimd, float_kernels_match_scalar_ones)
+{
+    checkKernelsAtAllLevels<float>();
+}
+
+TEST(TSimd, double_kernels_match_scalar_ones)
+{
+    checkKernelsAtAllLevels<double>();
+}
+
+TEST(TSimd, int_kernels_match_scalar_ones)
+{
+    checkKernelsAtAllLevels<int>();
+}
+
+TEST(TSimd, long_long_kernels_match_scalar_ones)
+{
+    checkKernelsAtAllLevels<long long>();
+}
+
+TEST(TSimd, int64_kernels_match_scalar_ones)
+{
+    checkKernelsAtAllLevels<int64_t>();
+}
+
+TEST(TSimd, unsigned_kernels_match_scalar_ones)
+{
+    checkKernelsAtAllLevels<unsigned>();
+    checkKernelsAtAllLevels<unsigned long long>();
+}
+
+TEST(TSimd, cant_set_level_above_supported)
+{
+    TSimdLevel old = simdLevel();
+    EXPECT_EQ(supportedSimdLevel(), setSimdLevel(SIMD_AVX512));
+    EXPECT_EQ(SIMD_NONE, setSimdLevel(SIMD_NONE));
+    setSimdLevel(old);
+}
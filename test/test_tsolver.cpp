@@ -0,0 +1,235 @@
+#include "tsolver.h"
+#include <gtest.h>
+
+#include <cmath>
+
+namespace
+{
+    // 1D Laplacian: tridiagonal (-1, 2 + shift, -1), symmetric positive definite
+    TCSRMatrix<double> laplacian(size_t n, double shift = 0)
+    {
+        TCSRBuilder<double> b(n);
+        for (size_t i = 0; i < n; i++) {
+            b.add(i, i, 2 + shift);
+            if (i > 0)
+                b.add(i, i - 1, -1);
+            if (i + 1 < n)
+                b.add(i, i + 1, -1);
+        }
+        return b.build();
+    }
+
+    // convection-diffusion: nonsymmetric, diagonally dominant
+    TCSRMatrix<double> convection(size_t n)
+    {
+        TCSRBuilder<double> b(n);
+        for (size_t i = 0; i < n; i++) {
+            b.add(i, i, 4 + 0.01 * double(i % 7));
+            if (i > 0)
+                b.add(i, i - 1, -1.5);
+            if (i + 1 < n)
+                b.add(i, i + 1, -0.5);
+            if (i + 5 < n)
+                b.add(i, i + 5, 0.3);
+        }
+        return b.build();
+    }
+
+    template<typename A>
+    double relativeError(const A& a, const TDynamicVector<double>& x, const TDynamicVector<double>& b)
+    {
+        TDynamicVector<double> r = a * x;
+        double rr = 0, bb = 0;
+        for (size_t i = 0; i < b.size(); i++) {
+            rr += (b[i] - r[i]) * (b[i] - r[i]);
+            bb += b[i] * b[i];
+        }
+        return std::sqrt(rr / bb);
+    }
+
+    TDynamicVector<double> rhs(size_t n)
+    {
+        TDynamicVector<double> b(n);
+        for (size_t i = 0; i < n; i++)
+            b[i] = double(i % 5) - 1.5;
+        return b;
+    }
+}
+
+TEST(TSolver, cg_solves_spd_csr_system)
+{
+    const size_t n = 200;
+    TCSRMatrix<double> a = laplacian(n, 0.01);
+    TDynamicVector<double> b = rhs(n), x(n);
+
+    TSolverResult res = TCGSolver<double>(n).solve(a, b, x);
+    EXPECT_TRUE(res.converged);
+    EXPECT_LE(res.iterations, n);
+    EXPECT_LT(relativeError(a, x, b), 1e-7);
+}
+
+TEST(TSolver, cg_works_on_band_and_dense_matrices)
+{
+    const size_t n = 40;
+    TBandMatrix<double> band(n, 1);
+    TDynamicMatrix<double> dense(n);
+    for (size_t i = 0; i < n; i++) {
+        band.at(i, i) = dense[i][i] = 3;
+        if (i > 0)
+            band.at(i, i - 1) = dense[i][i - 1] = -1;
+        if (i + 1 < n)
+            band.at(i, i + 1) = dense[i][i + 1] = -1;
+    }
+    TDynamicVector<double> b = rhs(n), x1(n), x2(n);
+    TCGSolver<double> cg(n);
+
+    EXPECT_TRUE(cg.solve(band, b, x1).converged);
+    EXPECT_TRUE(cg.solve(dense, b, x2).converged);
+    EXPECT_LT(relativeError(band, x1, b), 1e-7);
+    EXPECT_LT(relativeError(dense, x2, b), 1e-7);
+}
+
+TEST(TSolver, jacobi_preconditioner_keeps_cg_convergent)
+{
+    const size_t n = 150;
+    TCSRBuilder<double> bld(n);
+    for (size_t i = 0; i < n; i++) {
+        bld.add(i, i, 2 + double(i));
+        if (i > 0)
+            bld.add(i, i - 1, -1);
+        if (i + 1 < n)
+            bld.add(i, i + 1, -1);
+    }
+    TCSRMatrix<double> a = bld.build();
+    TDynamicVector<double> b = rhs(n), x(n), y(n);
+
+    TSolverResult plain = solveCG(a, b, x);
+    TSolverResult pre = solveCG(a, b, y, TJacobiPreconditioner<double>(a));
+    EXPECT_TRUE(plain.converged);
+    EXPECT_TRUE(pre.converged);
+    EXPECT_LT(pre.iterations, plain.iterations);
+    EXPECT_LT(relativeError(a, y, b), 1e-7);
+}
+
+TEST(TSolver, bicgstab_solves_nonsymmetric_system)
+{
+    const size_t n = 300;
+    TCSRMatrix<double> a = convection(n);
+    TDynamicVector<double> b = rhs(n), x(n);
+
+    TSolverResult res = solveBiCGStab(a, b, x, TJacobiPreconditioner<double>(a));
+    EXPECT_TRUE(res.converged);
+    EXPECT_LT(relativeError(a, x, b), 1e-7);
+}
+
+TEST(TSolver, gmres_solves_nonsymmetric_system_with_restarts)
+{
+    const size_t n = 300;
+    TCSRMatrix<double> a = convection(n);
+    TSellMatrix<double> sell(a);
+    TDynamicVector<double> b = rhs(n), x(n);
+
+    TGMRESSolver<double> gmres(n, 5);
+    TSolverResult res = gmres.solve(sell, b, x);
+    EXPECT_TRUE(res.converged);
+    EXPECT_GT(res.iterations, 5u);
+    EXPECT_LT(relativeError(a, x, b), 1e-7);
+
+    TSolverOptions other;
+    other.restart = 10;
+    ASSERT_ANY_THROW(gmres.solve(sell, b, x, TIdentityPreconditioner<double>(), other));
+    other.restart = 5;
+    ASSERT_NO_THROW(gmres.solve(sell, b, x, TIdentityPreconditioner<double>(), other));
+}
+
+TEST(TSolver, gmres_is_exact_within_full_subspace)
+{
+    const size_t n = 12;
+    TDynamicMatrix<double> a(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            a[i][j] = i == j ? 10.0 : double((i * 3 + j * 7) % 5) - 2;
+    TDynamicVector<double> b = rhs(n), x(n);
+
+    TSolverOptions opt;
+    opt.restart = n;
+    opt.tolerance = 1e-12;
+    TSolverResult res = solveGMRES(a, b, x, TIdentityPreconditioner<double>(), opt);
+    EXPECT_TRUE(res.converged);
+    EXPECT_LE(res.iterations, n);
+    EXPECT_LT(relativeError(a, x, b), 1e-10);
+}
+
+TEST(TSolver, callback_can_stop_iterations)
+{
+    const size_t n = 200;
+    TCSRMatrix<double> a = laplacian(n);
+    TDynamicVector<double> b = rhs(n), x(n);
+
+    size_t calls = 0;
+    TSolverOptions opt;
+    opt.callback = [&](size_t it, double) { calls++; return it < 3; };
+    TSolverResult res = TCGSolver<double>(n).solve(a, b, x, opt);
+    EXPECT_FALSE(res.converged);
+    EXPECT_EQ(3u, res.iterations);
+    EXPECT_EQ(3u, calls);
+}
+
+TEST(TSolver, stops_at_max_iterations)
+{
+    const size_t n = 200;
+    TCSRMatrix<double> a = laplacian(n);
+    TDynamicVector<double> b = rhs(n), x(n);
+
+    TSolverOptions opt;
+    opt.maxIterations = 4;
+    TSolverResult res = TBiCGStabSolver<double>(n).solve(a, b, x, opt);
+    EXPECT_FALSE(res.converged);
+    EXPECT_EQ(4u, res.iterations);
+}
+
+TEST(TSolver, zero_rhs_gives_zero_solution)
+{
+    const size_t n = 10;
+    TCSRMatrix<double> a = laplacian(n);
+    TDynamicVector<double> b(n), x(n);
+    x[3] = 5;
+
+    TSolverResult res = TGMRESSolver<double>(n).solve(a, b, x);
+    EXPECT_TRUE(res.converged);
+    EXPECT_EQ(0u, res.iterations);
+    EXPECT_EQ(TDynamicVector<double>(n), x);
+}
+
+TEST(TSolver, throws_when_sizes_differ)
+{
+    TCSRMatrix<double> a = laplacian(10);
+    TDynamicVector<double> b(10), x(10);
+    TCGSolver<double> cg(11);
+    ASSERT_ANY_THROW(cg.solve(a, b, x));
+    ASSERT_ANY_THROW(TGMRESSolver<double>(10, 0));
+}
+
+TEST(TSolver, jacobi_throws_on_zero_diagonal)
+{
+    TCSRMatrix<double> a(3);
+    ASSERT_ANY_THROW(TJacobiPreconditioner<double> m(a));
+}
+
+TEST(TSolver, jacobi_preconditioner_can_be_copied)
+{
+    static_assert(!std::is_constructible<TJacobiPreconditioner<double>, const TSellMatrix<double>&>::value, "");
+    TCSRMatrix<double> a = laplacian(10);
+    TJacobiPreconditioner<double> p1(a);
+    TJacobiPreconditioner<double> p2(p1);
+    const TJacobiPreconditioner<double>& c = p1;
+    TJacobiPreconditioner<double> p3(c);
+    p3 = p2;
+
+    TDynamicVector<double> r(10), z1(10), z2(10);
+    for (size_t i = 0; i < 10; i++)
+        r[i] = double(i) + 1;
+    p1.apply(r, z1);
+    p3.apply(r, z2);
+    EXPECT_EQ(z1, z2);
+}
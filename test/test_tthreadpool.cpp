@@ -0,0 +1,94 @@
+#include "tmatrix.h"
+#include <gtest.h>
+
+#include <atomic>
+#include <vector>
+
+TEST(TThreadPool, has_at_least_one_thread)
+{
+    EXPECT_GE(TThreadPool::instance().threadCount(), 1u);
+}
+
+TEST(TThreadPool, cant_set_zero_threads)
+{
+    ASSERT_ANY_THROW(TThreadPool::instance().setThreadCount(0));
+}
+
+TEST(TThreadPool, cant_set_thread_count_from_job)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(2);
+
+    std::atomic<int> thrown{0};
+    pool.parallelFor(4, [&](size_t) {
+        EXPECT_GE(pool.threadCount(), 1u);
+        try {
+            pool.setThreadCount(3);
+        }
+        catch (const std::logic_error&) {
+            thrown++;
+        }
+    });
+    EXPECT_EQ(4, thrown.load());
+    EXPECT_EQ(2u, pool.threadCount());
+
+    pool.setThreadCount(1);
+    EXPECT_THROW(pool.parallelFor(2, [&](size_t) { pool.setThreadCount(3); }), std::logic_error);
+    EXPECT_EQ(1u, pool.threadCount());
+
+    pool.setThreadCount(old);
+}
+
+TEST(TThreadPool, parallel_for_visits_every_index_once)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(4);
+
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallelFor(hits.size(), [&](size_t i) { hits[i]++; });
+    for (size_t i = 0; i < hits.size(); i++)
+        EXPECT_EQ(1, hits[i].load());
+
+    pool.setThreadCount(old);
+}
+
+TEST(TThreadPool, parallel_for_rethrows_exception)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(4);
+
+    ASSERT_ANY_THROW(pool.parallelFor(100, [](size_t i) {
+        if (i == 42)
+            throw std::runtime_error("err");
+    }));
+    //     
+    std::atomic<size_t> sum(0);
+    pool.parallelFor(10, [&](size_t i) { sum += i; });
+    EXPECT_EQ(45u, sum.load());
+
+    pool.setThreadCount(old);
+}
+
+TEST(TThreadPool, parallel_product_matches_serial_one)
+{
+    const size_t n = 300;
+    TDynamicMatrix<long long> m1(n), m2(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            m1[i][j] = (i * 7 + j * 3) % 11 - 5;
+            m2[i][j] = (i * 5 + j) % 13 - 6;
+        }
+
+    TThreadPool& pool = TThreadPool::instance();
+    size_t old = pool.threadCount();
+    pool.setThreadCount(1);
+    TDynamicMatrix<long long> serial = m1 * m2;
+    pool.setThreadCount(5);
+    TDynamicMatrix<long long> parallel = m1 * m2;
+    pool.setThreadCount(old);
+
+    EXPECT_EQ(serial, parallel);
+}
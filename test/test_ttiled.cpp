@@ -0,0 +1,178 @@
+#include "ttiled.h"
+#include <gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    TTiledOptions smallTiles()
+    {
+        TTiledOptions opt;
+        opt.tileSize = 16;
+        opt.cacheTiles = 5; // far fewer tiles than the matrices hold
+        return opt;
+    }
+
+    TDynamicMatrix<double> sample(size_t r, size_t c, double shift)
+    {
+        TDynamicMatrix<double> m(r, c);
+        for (size_t i = 0; i < r; i++)
+            for (size_t j = 0; j < c; j++)
+                m[i][j] = double((i * 7 + j * 3) % 11) - 5 + shift;
+        return m;
+    }
+}
+
+TEST(TTiledMatrix, can_set_and_get_elements_through_small_cache)
+{
+    TTiledMatrix<int> m(70, 45, smallTiles());
+    EXPECT_EQ(5u, m.tileRows());
+    EXPECT_EQ(3u, m.tileCols());
+    for (size_t i = 0; i < 70; i++)
+        for (size_t j = 0; j < 45; j++)
+            m.set(i, j, int(i * 100 + j));
+    for (size_t i = 0; i < 70; i++)
+        for (size_t j = 0; j < 45; j++)
+            ASSERT_EQ(int(i * 100 + j), m.get(i, j));
+    ASSERT_ANY_THROW(m.get(70, 0));
+    ASSERT_ANY_THROW(m.set(0, 45, 1));
+}
+
+TEST(TTiledMatrix, dense_round_trip)
+{
+    TDynamicMatrix<double> d = sample(37, 50, 0.25);
+    TTiledMatrix<double> m(d, smallTiles());
+    EXPECT_EQ(d, m.toDense());
+    EXPECT_EQ(d[36][49], m.get(36, 49));
+}
+
+TEST(TTiledMatrix, product_matches_dense_gemm)
+{
+    TDynamicMatrix<double> a = sample(70, 50, 0.5), b = sample(50, 45, -1);
+    TTiledMatrix<double> ta(a, smallTiles()), tb(b, smallTiles());
+
+    TDynamicMatrix<double> expected = a * b;
+    TDynamicMatrix<double> res = (ta * tb).toDense();
+    ASSERT_EQ(70u, res.rows());
+    ASSERT_EQ(45u, res.cols());
+    for (size_t i = 0; i < 70; i++)
+        for (size_t j = 0; j < 45; j++)
+            ASSERT_NEAR(expected[i][j], res[i][j], 1e-9);
+}
+
+TEST(TTiledMatrix, sum_matches_dense_and_works_in_place)
+{
+    TDynamicMatrix<double> a = sample(40, 33, 1), b = sample(40, 33, -2);
+    TTiledMatrix<double> ta(a, smallTiles()), tb(b, smallTiles());
+
+    TDynamicMatrix<double> sum = a + b;
+    EXPECT_EQ(sum, (ta + tb).toDense());
+    ta.add(tb, ta);
+    EXPECT_EQ(sum, ta.toDense());
+}
+
+TEST(TTiledMatrix, matvec_matches_dense)
+{
+    TDynamicMatrix<double> a = sample(60, 35, 0.125);
+    TTiledMatrix<double> ta(a, smallTiles());
+    TDynamicVector<double> x(35);
+    for (size_t i = 0; i < 35; i++)
+        x[i] = double(i % 6) - 2.5;
+
+    TDynamicVector<double> expected = a * x, y = ta * x;
+    for (size_t i = 0; i < 60; i++)
+        EXPECT_NEAR(expected[i], y[i], 1e-12);
+}
+
+TEST(TTiledMatrix, tile_handles_expose_edge_tiles)
+{
+    TTiledMatrix<float> m(20, 20, smallTiles());
+    {
+        TTiledMatrix<float>::TTile t = m.writeTile(1, 1);
+        EXPECT_EQ(4u, t.rows());
+        EXPECT_EQ(4u, t.cols());
+        EXPECT_EQ(16u, t.ld());
+        t.view()(3, 2) = 5;
+    }
+    EXPECT_EQ(5.0f, m.get(19, 18));
+    ASSERT_ANY_THROW(m.readTile(2, 0));
+}
+
+TEST(TTiledMatrix, can_exceed_dense_size_limit)
+{
+    // the file is sized but never filled, only touched tiles take memory
+    TTiledMatrix<double> m(MAX_MATRIX_SIZE + 2000, MAX_MATRIX_SIZE + 2000);
+    m.set(MAX_MATRIX_SIZE + 1999, MAX_MATRIX_SIZE + 1999, 3.5);
+    m.set(0, MAX_MATRIX_SIZE + 1500, -1);
+    EXPECT_EQ(3.5, m.get(MAX_MATRIX_SIZE + 1999, MAX_MATRIX_SIZE + 1999));
+    EXPECT_EQ(-1.0, m.get(0, MAX_MATRIX_SIZE + 1500));
+    EXPECT_EQ(0.0, m.get(5000, 5000));
+}
+
+TEST(TTiledMatrix, move_assignment_waits_for_background_reads)
+{
+    TDynamicMatrix<double> a = sample(64, 64, 0.5), b = sample(48, 32, -1);
+    TTiledMatrix<double> m(a, smallTiles());
+    for (int round = 0; round < 20; round++) {
+        TTiledMatrix<double> other(b, smallTiles());
+        other.flush();
+        for (size_t bi = 0; bi < m.tileRows(); bi++)
+            m.prefetch(bi, round % 4);
+        other.prefetch(1, 1);
+        m = std::move(other);
+        EXPECT_EQ(48u, m.rows());
+        EXPECT_EQ(b, m.toDense());
+        m = TTiledMatrix<double>(a, smallTiles());
+    }
+}
+
+TEST(TTileCache, failed_load_throws_for_every_waiter)
+{
+    // the file holds tile 0 only, reading tile 3 fails
+    TTileFile file("", 16 * sizeof(double));
+    TTileCache<double> cache(file, 16, 5);
+    cache.prefetch(3);
+    std::atomic<int> thrown{0};
+    std::vector<std::thread> threads;
+    for (int k = 0; k < 4; k++)
+        threads.emplace_back([&, k] {
+            try {
+                cache.acquire(3, k % 2 == 0);
+            }
+            catch (const std::runtime_error&) {
+                thrown++;
+            }
+        });
+    for (std::thread& t : threads)
+        t.join();
+    EXPECT_EQ(4, thrown.load());
+    ASSERT_ANY_THROW(cache.acquire(3, false));
+
+    double* p = cache.acquire(0, true, true);
+    p[5] = 2.5;
+    cache.release(0);
+    cache.flush();
+    EXPECT_EQ(2.5, cache.acquire(0, false)[5]);
+    cache.release(0);
+}
+
+TEST(TTiledMatrix, throws_on_bad_arguments)
+{
+    TTiledOptions tiny = smallTiles();
+    tiny.cacheTiles = 4;
+    ASSERT_ANY_THROW(TTiledMatrix<double>(10, 10, tiny));
+    ASSERT_ANY_THROW(TTiledMatrix<double>(0, 10, smallTiles()));
+
+    TTiledMatrix<double> a(20, 30, smallTiles()), b(20, 30, smallTiles()), c(20, 30, smallTiles());
+    ASSERT_ANY_THROW(a * b);
+    ASSERT_ANY_THROW(a.multiply(a, a));
+    TTiledOptions other = smallTiles();
+    other.tileSize = 8;
+    TTiledMatrix<double> d(30, 20, other);
+    ASSERT_ANY_THROW(a * d);
+    ASSERT_NO_THROW(a.add(b, c));
+    TDynamicVector<double> x(20);
+    ASSERT_ANY_THROW(a * x);
+}
@@ -16,6 +16,32 @@ TEST(TDynamicVector, throws_when_create_vector_with_negative_length)
     ASSERT_ANY_THROW(TDynamicVector<int> v(-5));
 }
 
+
+TEST(TDynamicVector, sized_vector_is_zero_filled)
+{
+    TDynamicVector<double> v(100);
+    for (size_t i = 0; i < v.size(); i++)
+        EXPECT_EQ(0.0, v[i]);
+}
+
+TEST(TDynamicVector, no_init_constructor_checks_size)
+{
+    ASSERT_NO_THROW(TDynamicVector<int> v(5, TNoInit()));
+    ASSERT_ANY_THROW(TDynamicVector<int> v(0, TNoInit()));
+    ASSERT_ANY_THROW(TDynamicVector<int> v(MAX_VECTOR_SIZE + 1, TNoInit()));
+}
+
+
+TEST(TDynamicVector, memory_is_aligned)
+{
+    for (size_t n : { 1, 3, 17, 1000 }) {
+        TDynamicVector<double> v(n);
+        TDynamicVector<char> c(n, TNoInit());
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v.data()) % MEMORY_ALIGNMENT);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(c.data()) % MEMORY_ALIGNMENT);
+    }
+}
+
 TEST(TDynamicVector, can_create_copied_vector)
 {
     TDynamicVector<int> v(10);
@@ -218,6 +244,78 @@ TEST(TDynamicVector, cant_multiply_vectors_with_not_equal_size)
     ASSERT_ANY_THROW(v1 * v2);
 }
 
+TEST(TDynamicVector, can_evaluate_fused_expression)
+{
+    TDynamicVector<int> a(3), b(3), d(3), expected(3);
+    a[0] = 1; a[1] = 2; a[2] = 3;
+    b[0] = 4; b[1] = 5; b[2] = 6;
+    d[0] = 1; d[1] = 1; d[2] = 1;
+    expected[0] = 8; expected[1] = 11; expected[2] = 14;
+
+    TDynamicVector<int> c = a + b * 2 - d;
+    EXPECT_EQ(expected, c);
+}
+
+TEST(TDynamicVector, can_assign_expression_referring_to_itself)
+{
+    TDynamicVector<int> a(3), b(3), expected(3);
+    a[0] = 1; a[1] = 2; a[2] = 3;
+    b[0] = 1; b[1] = 1; b[2] = 1;
+    expected[0] = 4; expected[1] = 6; expected[2] = 8;
+
+    a = (a + b) * 2;
+    EXPECT_EQ(expected, a);
+}
+
+TEST(TDynamicVector, assign_expression_changes_vector_size)
+{
+    TDynamicVector<int> a(3), b(3), c(5);
+    a[0] = 1; a[1] = 2; a[2] = 3;
+
+    c = a - b + 1;
+    EXPECT_EQ(3, c.size());
+    EXPECT_EQ(4, c[2]);
+}
+
+TEST(TDynamicVector, cant_build_expression_of_vectors_with_not_equal_size)
+{
+    TDynamicVector<int> v1(3), v2(3), v3(5);
+    ASSERT_ANY_THROW(v1 + v2 - v3);
+}
+
+TEST(TDynamicVector, compound_assignment_works_in_place)
+{
+    TDynamicVector<int> v1(3), v2(3), expected(3);
+    v1[0] = 1; v1[1] = 2; v1[2] = 3;
+    v2[0] = 4; v2[1] = 5; v2[2] = 6;
+    expected[0] = 6; expected[1] = 9; expected[2] = 12;
+
+    const int* mem = v1.data();
+    v1 += v2;
+    v1 -= v2 * 0 + 1;
+    v1 *= 6;
+    v1 /= 4;
+
+    EXPECT_EQ(expected, v1);
+    EXPECT_EQ(mem, v1.data());
+}
+
+TEST(TDynamicVector, cant_add_in_place_vectors_with_not_equal_size)
+{
+    TDynamicVector<int> v1(3), v2(5);
+    ASSERT_ANY_THROW(v1 += v2);
+    ASSERT_ANY_THROW(v1 -= v2);
+}
+
+TEST(TDynamicVector, can_multiply_expressions)
+{
+    TDynamicVector<int> v1(2), v2(2);
+    v1[0] = 1; v1[1] = 2;
+    v2[0] = 3; v2[1] = 4;
+
+    EXPECT_EQ(20, (v1 + v2) * (v2 - v1));
+}
+
 TEST(TDynamicVector, can_use_move_constructor)
 {
     TDynamicVector<int> v1(3);
@@ -278,6 +376,152 @@ TEST(TDynamicVector, input_output_operators_work)
     EXPECT_EQ(v, v2);
 }
 
+namespace
+{
+    // output of the element operators, one element at a time
+    template<typename T>
+    std::string elementwise(const TDynamicVector<T>& v, const std::ios_base& fmt)
+    {
+        std::ostringstream os;
+        os.flags(fmt.flags());
+        os.precision(fmt.precision());
+        for (size_t i = 0; i < v.size(); i++)
+            os << v[i] << ' ';
+        return os.str();
+    }
+}
+
+TEST(TDynamicVector, text_output_matches_element_operators)
+{
+    TDynamicVector<double> v(6);
+    v[0] = 1.0 / 3;
+    v[1] = -2.5e-300;
+    v[2] = 1e21;
+    v[3] = 0;
+    v[4] = -7;
+    v[5] = 123456.789;
+
+    std::ostringstream os;
+    os << v;
+    EXPECT_EQ(elementwise(v, os), os.str());
+
+    std::ostringstream fixed;
+    fixed << std::fixed;
+    fixed.precision(3);
+    fixed << v;
+    EXPECT_EQ(elementwise(v, fixed), fixed.str());
+
+    std::ostringstream sci;
+    sci << std::scientific;
+    sci << v;
+    EXPECT_EQ(elementwise(v, sci), sci.str());
+
+    std::ostringstream plus;
+    plus << std::showpos << v;
+    EXPECT_EQ(elementwise(v, plus), plus.str());
+}
+
+TEST(TDynamicVector, text_round_trip_is_exact_with_full_precision)
+{
+    const size_t n = 100000;
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = (double(i) - 5000.5) / 7.0;
+
+    std::stringstream ss;
+    ss.precision(17);
+    ss << v;
+    TDynamicVector<double> v2(n);
+    ss >> v2;
+    EXPECT_FALSE(ss.fail());
+    EXPECT_EQ(v, v2);
+}
+
+TEST(TDynamicVector, text_input_accepts_signs_and_any_whitespace)
+{
+    std::stringstream ss(" +1\t-2\n\n 3e2\r\n 4. 99");
+    TDynamicVector<double> v(4);
+    ss >> v;
+    EXPECT_TRUE(ss.good());
+    EXPECT_EQ(1.0, v[0]);
+    EXPECT_EQ(-2.0, v[1]);
+    EXPECT_EQ(300.0, v[2]);
+    EXPECT_EQ(4.0, v[3]);
+    int rest;
+    ss >> rest;
+    EXPECT_EQ(99, rest);
+}
+
+TEST(TDynamicVector, text_input_fails_like_element_operators)
+{
+    std::stringstream bad("1 2 x 4");
+    TDynamicVector<int> v(4);
+    bad >> v;
+    EXPECT_TRUE(bad.fail());
+    EXPECT_EQ(1, v[0]);
+    EXPECT_EQ(2, v[1]);
+
+    std::stringstream shortInput("5 6");
+    shortInput >> v;
+    EXPECT_TRUE(shortInput.fail());
+    EXPECT_TRUE(shortInput.eof());
+    EXPECT_EQ(5, v[0]);
+    EXPECT_EQ(6, v[1]);
+
+    std::stringstream exact("7 8 9 10");
+    exact >> v;
+    EXPECT_FALSE(exact.fail());
+    EXPECT_TRUE(exact.eof());
+    EXPECT_EQ(10, v[3]);
+}
+
+template<typename T>
+void expectSameInputAsElements(const std::string& text, size_t size)
+{
+    std::stringstream fast(text), slow(text);
+    TDynamicVector<T> v(size);
+    std::vector<T> e(size);
+    for (size_t i = 0; i < size; i++)
+        v[i] = e[i] = T(7);
+    fast >> v;
+    for (size_t i = 0; i < size; i++)
+        slow >> e[i];
+    EXPECT_EQ(slow.fail(), fast.fail()) << text;
+    EXPECT_EQ(slow.eof(), fast.eof()) << text;
+    for (size_t i = 0; i < size; i++)
+        EXPECT_EQ(e[i], v[i]) << text << " [" << i << "]";
+    fast.clear();
+    slow.clear();
+    std::string fastRest, slowRest;
+    std::getline(fast, fastRest, '\0');
+    std::getline(slow, slowRest, '\0');
+    EXPECT_EQ(slowRest, fastRest) << text;
+}
+
+TEST(TDynamicVector, text_input_failures_match_element_operators)
+{
+    for (const char* s : { "1 2 x 4", "1.5 2 3 4", "1 2", "+-1 2 3 4", "1 2 3 99999999999 5",
+        "-2147483648 2147483647 0012 3 4", "1 2 3 4 5 6", "1 2 3 4\n", "1 -0 +0 3" })
+        expectSameInputAsElements<int>(s, 4);
+    for (const char* s : { "-5 7 +3 2", "1 2 -4294967296 3", "4294967295 1 2 3" })
+        expectSameInputAsElements<unsigned>(s, 4);
+    for (const char* s : { "1 inf 2 3", "1 nan 2 3", "1e 2 3 4", "1e+ 2 3 4", "1.2.3 4 5",
+        ".5 -.5e1 1e-400 1e400", "1. .e5 3 4", "- 1 2 3", "1e308 -1e308 4.9e-324 2e-308", "1 2 3 4e5x" })
+        expectSameInputAsElements<double>(s, 4);
+    for (const char* s : { "1e38 3e38 4e38 1", "1e-38 1e-45 1e-50 1" })
+        expectSameInputAsElements<float>(s, 4);
+}
+
+TEST(TDynamicVector, large_text_input_stops_at_first_bad_element)
+{
+    const size_t n = 200000;
+    std::ostringstream os;
+    for (size_t i = 0; i < n; i++)
+        os << (i == 150000 ? "1.5" : i == 150001 ? "x" : std::to_string(i)) << ' ';
+    expectSameInputAsElements<int>(os.str(), n);
+    expectSameInputAsElements<long long>(os.str(), n);
+}
+
 TEST(TDynamicVector, scalar_operations_with_double)
 {
     TDynamicVector<double> v(2);
@@ -296,3 +540,47 @@ TEST(TDynamicVector, scalar_operations_with_double)
     EXPECT_DOUBLE_EQ(3.0, result_mul[0]);
     EXPECT_DOUBLE_EQ(5.0, result_mul[1]);
 }
+
+TEST(TDynamicVector, expiring_operand_buffer_is_reused)
+{
+    const size_t n = 37;
+    TDynamicVector<double> a(n), b(n), c(n);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = double(i);
+        b[i] = double(i % 5) - 2;
+        c[i] = 0.5 * double(i % 3);
+    }
+    TDynamicVector<double> expected(n);
+    for (size_t i = 0; i < n; i++)
+        expected[i] = a[i] + b[i] - c[i] * 2 + 1;
+
+    const double* buf = a.data();
+    TDynamicVector<double> r = std::move(a) + b - c * 2.0 + 1.0;
+    EXPECT_EQ(buf, r.data());
+    EXPECT_EQ(expected, r);
+
+    buf = r.data();
+    TDynamicVector<double> s = b - std::move(r);
+    EXPECT_EQ(buf, s.data());
+    for (size_t i = 0; i < n; i++)
+        EXPECT_EQ(b[i] - expected[i], s[i]);
+}
+
+TEST(TDynamicVector, temporary_operands_give_same_values_as_lvalues)
+{
+    TDynamicVector<int> a(4), b(4);
+    for (size_t i = 0; i < 4; i++) {
+        a[i] = int(i) + 1;
+        b[i] = 10 * int(i);
+    }
+    TDynamicVector<int> sum = a + b, diff = a - b, scaled = a * 3, shifted = a - 2;
+    EXPECT_EQ(sum, TDynamicVector<int>(a) + TDynamicVector<int>(b));
+    EXPECT_EQ(sum, a + TDynamicVector<int>(b));
+    EXPECT_EQ(diff, TDynamicVector<int>(a) - TDynamicVector<int>(b));
+    EXPECT_EQ(diff, a - TDynamicVector<int>(b));
+    EXPECT_EQ(scaled, TDynamicVector<int>(a) * 3);
+    EXPECT_EQ(shifted, TDynamicVector<int>(a) - 2);
+    EXPECT_EQ(200, TDynamicVector<int>(a) * b); // still the dot product
+    ASSERT_ANY_THROW(TDynamicVector<int>(3) + a);
+    ASSERT_ANY_THROW(a - TDynamicVector<int>(5));
+}